@@ -0,0 +1,99 @@
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <vector>
+#include "checks.h"
+#include "fft.h"
+
+
+// Transform of n x n random samples, read transposed as Fft2D does, against the naive DFT : largest difference
+static double dftError(int n, bool inverse, ThreadPool &pool)
+{
+    Fft2D fft(n);
+    int stride = fft.getRowStride();
+    std::vector<std::complex<double> > spectre(n*n);
+    for(int kz = 0; kz < n; kz++) {
+        for(int kx = 0; kx < n; kx++) {
+            spectre[kz*n + kx] = std::complex<double>(rand() / double(RAND_MAX) - 0.5, rand() / double(RAND_MAX) - 0.5);
+            fft.real()[kx*stride + kz] = spectre[kz*n + kx].real();
+            fft.imag()[kx*stride + kz] = spectre[kz*n + kx].imag();
+        }
+    }
+    fft.transformTransposed(inverse, pool);
+
+    double signe = inverse ? 1 : -1;
+    double erreur = 0;
+    for(int z = 0; z < n; z++) {
+        for(int x = 0; x < n; x++) {
+            std::complex<double> somme = 0;
+            for(int kz = 0; kz < n; kz++) {
+                for(int kx = 0; kx < n; kx++) {
+                    somme += spectre[kz*n + kx]*std::polar(1.0, signe*2*M_PI*((z*kz + x*kx) % n) / n);
+                }
+            }
+            std::complex<double> resultat(fft.real()[z*stride + x], fft.imag()[z*stride + x]);
+            erreur = std::max(erreur, std::abs(somme - resultat));
+        }
+    }
+    return erreur;
+}
+
+
+// Forward then inverse transform, divided by n^2 : largest difference with the samples
+static double roundTripError(int n, ThreadPool &pool)
+{
+    Fft2D fft(n);
+    int stride = fft.getRowStride();
+    std::vector<float> re(n*n), im(n*n);
+    for(int i = 0; i < n*n; i++) {
+        re[i] = rand() / double(RAND_MAX) - 0.5;
+        im[i] = rand() / double(RAND_MAX) - 0.5;
+    }
+    // The input is read transposed, the output is not : transposed again between the two transforms
+    for(int ligne = 0; ligne < n; ligne++) {
+        for(int colonne = 0; colonne < n; colonne++) {
+            fft.real()[colonne*stride + ligne] = re[ligne*n + colonne];
+            fft.imag()[colonne*stride + ligne] = im[ligne*n + colonne];
+        }
+    }
+    fft.transformTransposed(false, pool);
+    std::vector<float> reSpectre(n*n), imSpectre(n*n);
+    for(int ligne = 0; ligne < n; ligne++) {
+        for(int colonne = 0; colonne < n; colonne++) {
+            reSpectre[ligne*n + colonne] = fft.real()[colonne*stride + ligne];
+            imSpectre[ligne*n + colonne] = fft.imag()[colonne*stride + ligne];
+        }
+    }
+    for(int ligne = 0; ligne < n; ligne++) {
+        for(int colonne = 0; colonne < n; colonne++) {
+            fft.real()[ligne*stride + colonne] = reSpectre[ligne*n + colonne];
+            fft.imag()[ligne*stride + colonne] = imSpectre[ligne*n + colonne];
+        }
+    }
+    fft.transformTransposed(true, pool);
+
+    double erreur = 0;
+    for(int ligne = 0; ligne < n; ligne++) {
+        for(int colonne = 0; colonne < n; colonne++) {
+            std::complex<double> resultat(fft.real()[ligne*stride + colonne], fft.imag()[ligne*stride + colonne]);
+            erreur = std::max(erreur, std::abs(resultat / double(n*n) - std::complex<double>(re[ligne*n + colonne],
+                                                                                            im[ligne*n + colonne])));
+        }
+    }
+    return erreur;
+}
+
+
+bool checkFft()
+{
+    ThreadPool pool(2);
+    srand(1);
+    bool ok = true;
+    // 16 : radix 4 passes only, 32 : with the radix 2 pass, 256 : several column blocks on the pool
+    ok = checkBelow("FFT 16x16 against the DFT", dftError(16, false, pool), 1e-5) && ok;
+    ok = checkBelow("FFT 32x32 inverse against the DFT", dftError(32, true, pool), 2e-5) && ok;
+    ok = checkBelow("FFT 64x64 against the DFT", dftError(64, false, pool), 4e-5) && ok;
+    ok = checkBelow("FFT 32x32 round trip", roundTripError(32, pool), 1e-6) && ok;
+    ok = checkBelow("FFT 256x256 round trip", roundTripError(256, pool), 1e-6) && ok;
+    return ok;
+}
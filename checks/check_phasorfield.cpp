@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "checks.h"
+#include "phasorfield.h"
+
+
+const int PHASOR_CHECK_SIZE = 160;
+
+// Rings of two frequencies over the grid of a PhasorField, against the direct sum of the CircularWave kernels
+bool checkPhasorField()
+{
+    ThreadPool pool(2);
+    int n = PHASOR_CHECK_SIZE;
+    HeightField field(n, n, -n/2, -n/2, 1.0), reference(n, n, -n/2, -n/2, 1.0);
+    WaveTable<CircularWaveColumns> table;
+    srand(1);
+    for(int i = 0; i < 24; i++) {
+        Point origine(rand() % n - n/2, 0, rand() % n - n/2);
+        GLfloat hauteur = 0.2 + 0.01*(rand() % 50);
+        table.add(CircularWave(origine, hauteur, 4, rand() % 20, i % 2 == 0 ? 10 : 14, 0));
+    }
+
+    // The phasor field is incremental : the same one follows the rings from frame to frame
+    PhasorField phasors;
+    double ecart = 0;
+    int nbGroupees = 0;
+    for(int frame = 0; frame < 150; frame++) {
+        double delta_t = 1 / 60.0;
+        phasors.update(table, field.getView(), delta_t, pool);
+        nbGroupees = phasors.getNbSources();
+        field.fill(0);
+        phasors.deformRows(field.getView(), 0, n);
+        reference.fill(0);
+        table.deformRows(reference.getView(), 0, n);
+        for(int ligne = 0; ligne < n; ligne++) {
+            for(int colonne = 0; colonne < n; colonne++) {
+                int i = field.index(ligne, colonne);
+                ecart = std::max(ecart, double(fabs(field.heights()[i] - reference.heights()[i])));
+            }
+        }
+        table.update(delta_t, n, n);
+    }
+    bool ok = checkBelow("Phasor field : waves left out of the groups", table.size() - nbGroupees, 0);
+    ok = checkBelow("Phasor field : difference with the direct sum", ecart, 3e-4) && ok;
+    return ok;
+}
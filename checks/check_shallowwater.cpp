@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "checks.h"
+#include "shallowwater.h"
+#include "wavekernels.h"
+
+
+const int SHALLOW_CHECK_SIZE = 101;
+
+// Slope with a hill rising above the water level of the solver (5) : an island whose shore dries and floods
+static HeightField makeBathymetry()
+{
+    int n = SHALLOW_CHECK_SIZE;
+    HeightField bathymetry(n, n, 0, 0, 1.0);
+    for(int ligne = 0; ligne < n; ligne++) {
+        for(int colonne = 0; colonne < n; colonne++) {
+            double dx = colonne - n*0.5, dz = ligne - n*0.6;
+            bathymetry.heights()[bathymetry.index(ligne, colonne)] = 6*exp(-(dx*dx + dz*dz) / (n*n*0.01))
+                                                                     + 2.0*colonne / n;
+        }
+    }
+    return bathymetry;
+}
+
+static double totalDepth(const ShallowWaterSolver &solver)
+{
+    const HeightField &depth = solver.getDepth();
+    double somme = 0;
+    for(int ligne = 0; ligne < depth.getNbPointsZ(); ligne++) {
+        for(int colonne = 0; colonne < depth.getNbPointsX(); colonne++) {
+            somme += depth.heights()[depth.index(ligne, colonne)];
+        }
+    }
+    return somme;
+}
+
+static double minDepth(const ShallowWaterSolver &solver)
+{
+    const HeightField &depth = solver.getDepth();
+    double minimum = depth.heights()[0];
+    for(int ligne = 0; ligne < depth.getNbPointsZ(); ligne++) {
+        for(int colonne = 0; colonne < depth.getNbPointsX(); colonne++) {
+            minimum = std::min(minimum, double(depth.heights()[depth.index(ligne, colonne)]));
+        }
+    }
+    return minimum;
+}
+
+// History of checkShallowWater : the lake at rest, then 301 steps fed by the sources
+static void run(const HeightField &bathymetry, const HeightField &sources, HeightField &field, ThreadPool &pool)
+{
+    ShallowWaterSolver solver;
+    solver.reset(bathymetry);
+    for(int i = 0; i < 100; i++) {
+        solver.advance(field, NULL, 0.05, pool);
+    }
+    for(int i = 0; i < 301; i++) {
+        solver.advance(field, &sources, 0.016, pool);
+    }
+}
+
+
+bool checkShallowWater()
+{
+    ThreadPool pool(2);
+    bool ok = true;
+    int n = SHALLOW_CHECK_SIZE;
+    HeightField bathymetry = makeBathymetry();
+    HeightField field(n, n, 0, 0, 1.0);
+
+    // Lake at rest : the hydrostatic reconstruction balances the slopes of the bed
+    ShallowWaterSolver solver;
+    solver.reset(bathymetry);
+    for(int i = 0; i < 100; i++) {
+        solver.advance(field, NULL, 0.05, pool);
+    }
+    double courant = 0, surface = 0;
+    for(int ligne = 0; ligne < n; ligne++) {
+        for(int colonne = 0; colonne < n; colonne++) {
+            int i = field.index(ligne, colonne);
+            courant = std::max(courant, double(fabs(solver.getMomentumX().heights()[i])
+                                               + fabs(solver.getMomentumZ().heights()[i])));
+            if(solver.getDepth().heights()[i] > 0) {
+                surface = std::max(surface, fabs(field.heights()[i] - solver.getWaterLevel()));
+            }
+        }
+    }
+    ok = checkBelow("Shallow water : momentum of the lake at rest", courant, 1e-4) && ok;
+    ok = checkBelow("Shallow water : surface of the lake at rest", surface, 1e-4) && ok;
+
+    // A source pushes the water once, then the walls keep it : the depths stay positive and their sum constant
+    HeightField sources(n, n, 0, 0, 1.0);
+    for(int ligne = 0; ligne < n; ligne++) {
+        for(int colonne = 0; colonne < n; colonne++) {
+            double dx = colonne - 25, dz = ligne - 25;
+            sources.heights()[sources.index(ligne, colonne)] = 10*exp(-(dx*dx + dz*dz) / 30);
+        }
+    }
+    solver.advance(field, &sources, 0.016, pool);
+    double eau = totalDepth(solver), profondeurMin = 0;
+    for(int i = 0; i < 300; i++) {
+        solver.advance(field, &sources, 0.016, pool);
+        profondeurMin = std::min(profondeurMin, minDepth(solver));
+    }
+    ok = checkBelow("Shallow water : relative drift of the water", fabs(totalDepth(solver) - eau) / eau, 1e-5) && ok;
+    ok = checkBelow("Shallow water : largest negative depth", std::max(0.0, -profondeurMin), 0) && ok;
+
+    // Same surface as the scalar kernels, after the same history
+    std::vector<float> resultat(field.heights(), field.heights() + field.getPlaneSize());
+    WaveKernelIsa isa = getWaveKernels().isa;
+    selectWaveKernels(WAVE_KERNEL_SCALAR);
+    run(bathymetry, sources, field, pool);
+    selectWaveKernels(isa);
+    double ecart = 0;
+    for(int i = 0; i < field.getPlaneSize(); i++) {
+        ecart = std::max(ecart, double(fabs(resultat[i] - field.heights()[i])));
+    }
+    ok = checkBelow("Shallow water : difference with the scalar kernels", ecart, 1e-4) && ok;
+    return ok;
+}
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "checks.h"
+#include "surfaceorder.h"
+
+
+const int ORDER_CHECK_SIZE = 100;
+
+// Triangles of a list of indices, each one turned so that its smallest vertex comes first (same winding), sorted
+static std::vector<std::vector<GLuint> > sortedTriangles(const std::vector<GLuint> &indices)
+{
+    std::vector<std::vector<GLuint> > triangles;
+    for(int i = 0; i + 2 < int(indices.size()); i += 3) {
+        std::vector<GLuint> triangle(indices.begin() + i, indices.begin() + i + 3);
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+
+bool checkSurfaceOrder()
+{
+    int n = ORDER_CHECK_SIZE;
+    // ACMR measured on 100x100 points, listed in surfaceorder.h
+    const double bornes[SURFACE_ORDER_COUNT] = {2.05, 0.6, 0.7};
+    bool ok = true;
+
+    std::vector<GLuint> indices;
+    buildGridIndices(indices, n, n, SURFACE_ORDER_ROWS);
+    std::vector<std::vector<GLuint> > reference = sortedTriangles(indices);
+    for(int ordre = 0; ordre < SURFACE_ORDER_COUNT; ordre++) {
+        buildGridIndices(indices, n, n, SurfaceOrder(ordre));
+        char nom[64];
+        snprintf(nom, sizeof(nom), "Surface order %s : ACMR", getSurfaceOrderName(SurfaceOrder(ordre)));
+        ok = checkBelow(nom, computeAcmr(indices, n*n), bornes[ordre]) && ok;
+        snprintf(nom, sizeof(nom), "Surface order %s : triangles unlike rows", getSurfaceOrderName(SurfaceOrder(ordre)));
+        std::vector<std::vector<GLuint> > triangles = sortedTriangles(indices);
+        int differents = abs(int(triangles.size()) - int(reference.size()));
+        for(int i = 0; i < int(std::min(triangles.size(), reference.size())); i++) {
+            if(triangles[i] != reference[i]) {
+                differents++;
+            }
+        }
+        ok = checkBelow(nom, differents, 0) && ok;
+    }
+    return ok;
+}
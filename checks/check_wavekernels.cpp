@@ -0,0 +1,42 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "checks.h"
+#include "wavekernels.h"
+
+
+// Arguments spread over [debut, fin], with a length that leaves a tail to the scalar code of the SIMD kernels
+static std::vector<GLfloat> sweep(double debut, double fin)
+{
+    std::vector<GLfloat> x(1000003);
+    for(size_t i = 0; i < x.size(); i++) {
+        x[i] = debut + (fin - debut)*i / (x.size() - 1);
+    }
+    return x;
+}
+
+
+// Approximations of exp and cos of the kernels against the double precision libm, on the ranges they are used on
+bool checkWaveKernels()
+{
+    const WaveKernels &kernels = getWaveKernels();
+    bool ok = true;
+
+    std::vector<GLfloat> x = sweep(-87, 88), y(x.size());
+    kernels.expRow(&x[0], &y[0], x.size());
+    double erreur = 0;
+    for(size_t i = 0; i < x.size(); i++) {
+        double reference = exp(double(x[i]));
+        erreur = std::max(erreur, fabs(y[i] - reference) / reference);
+    }
+    ok = checkBelow("exp relative error on [-87, 88]", erreur, 2e-7) && ok;
+
+    x = sweep(-8192, 8192);
+    kernels.cosRow(&x[0], &y[0], x.size());
+    erreur = 0;
+    for(size_t i = 0; i < x.size(); i++) {
+        erreur = std::max(erreur, fabs(y[i] - cos(double(x[i]))));
+    }
+    ok = checkBelow("cos absolute error on [-8192, 8192]", erreur, 1.5e-7) && ok;
+    return ok;
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "checks.h"
+#include "wavekernels.h"
+#include "wavesolver.h"
+
+
+const int WAVE_CHECK_SIZE = 101;
+
+static HeightField makeField()
+{
+    HeightField field(WAVE_CHECK_SIZE, WAVE_CHECK_SIZE, -50, -50, 1.0);
+    field.enableSpeeds();
+    field.enableAccelerations();
+    field.fill(0);
+    field.resetMotion();
+    return field;
+}
+
+// Gaussian bump off the center, so that the reflections on the borders are not symmetric
+static void addBump(HeightField &field, double hauteur)
+{
+    for(int ligne = 0; ligne < field.getNbPointsZ(); ligne++) {
+        for(int colonne = 0; colonne < field.getNbPointsX(); colonne++) {
+            double dx = field.x(colonne) - 12, dz = field.z(ligne) + 7;
+            field.heights()[field.index(ligne, colonne)] += hauteur*exp(-(dx*dx + dz*dz) / 20);
+        }
+    }
+}
+
+static double meanHeight(const HeightField &field)
+{
+    double somme = 0;
+    for(int ligne = 0; ligne < field.getNbPointsZ(); ligne++) {
+        for(int colonne = 0; colonne < field.getNbPointsX(); colonne++) {
+            somme += field.heights()[field.index(ligne, colonne)];
+        }
+    }
+    return somme / field.getNbPoints();
+}
+
+static double maxHeight(const HeightField &field)
+{
+    double maximum = 0;
+    for(int ligne = 0; ligne < field.getNbPointsZ(); ligne++) {
+        for(int colonne = 0; colonne < field.getNbPointsX(); colonne++) {
+            maximum = std::max(maximum, double(fabs(field.heights()[field.index(ligne, colonne)])));
+        }
+    }
+    return maximum;
+}
+
+// A bump, then 2 seconds of the default solver fed by a source
+static HeightField run(ThreadPool &pool)
+{
+    WaveEquationSolver solver;
+    HeightField field = makeField();
+    HeightField sources = makeField();
+    addBump(field, 3);
+    addBump(sources, 1);
+    for(int i = 0; i < 125; i++) {
+        solver.advance(field, &sources, 0.016, pool);
+    }
+    return field;
+}
+
+
+bool checkWaveSolver()
+{
+    ThreadPool pool(2);
+    bool ok = true;
+
+    WaveEquationSolver solver;
+    HeightField field = makeField();
+    for(int i = 0; i < 60; i++) {
+        solver.advance(field, NULL, 0.016, pool);
+    }
+    ok = checkBelow("Wave equation : flat field at rest", maxHeight(field), 0) && ok;
+
+    // Without stiffness, damping nor source, the reflecting borders keep the water : the mean height stays
+    solver.setStiffness(0);
+    solver.setDamping(0);
+    addBump(field, 3);
+    double moyenne = meanHeight(field);
+    for(int i = 0; i < 250; i++) {
+        solver.advance(field, NULL, 0.016, pool);
+    }
+    ok = checkBelow("Wave equation : mean height drift", fabs(meanHeight(field) - moyenne), 1e-5) && ok;
+    ok = checkBelow("Wave equation : undamped waves stay bounded", maxHeight(field), 3) && ok;
+
+    // The damping takes the energy away
+    solver.setDamping(2);
+    for(int i = 0; i < 250; i++) {
+        solver.advance(field, NULL, 0.016, pool);
+    }
+    ok = checkBelow("Wave equation : damped waves after 4 s", maxHeight(field), 0.1) && ok;
+
+    // Same heights as the scalar kernels, up to the rounding of the float operations
+    HeightField resultat = run(pool);
+    WaveKernelIsa isa = getWaveKernels().isa;
+    selectWaveKernels(WAVE_KERNEL_SCALAR);
+    HeightField reference = run(pool);
+    selectWaveKernels(isa);
+    double ecart = 0;
+    for(int i = 0; i < resultat.getPlaneSize(); i++) {
+        ecart = std::max(ecart, double(fabs(resultat.heights()[i] - reference.heights()[i])));
+    }
+    ok = checkBelow("Wave equation : difference with the scalar kernels", ecart / maxHeight(reference), 1e-5) && ok;
+    return ok;
+}
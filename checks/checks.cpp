@@ -0,0 +1,31 @@
+#include <cstdio>
+#include "checks.h"
+#include "wavekernels.h"
+
+
+bool checkBelow(const char *name, double value, double bound)
+{
+    bool ok = value <= bound;
+    printf("  %-50s %12.4g  (%g)%s\n", name, value, bound, ok ? "" : "  FAILED");
+    return ok;
+}
+
+
+int main()
+{
+    // Without kernels
+    bool ok = checkSurfaceOrder();
+    for(int isa = WAVE_KERNEL_SCALAR; isa <= WAVE_KERNEL_AVX512; isa++) {
+        if(!selectWaveKernels(WaveKernelIsa(isa))) {
+            continue;
+        }
+        printf("%s\n", getWaveKernelIsaName(WaveKernelIsa(isa)));
+        ok = checkWaveKernels() && ok;
+        ok = checkFft() && ok;
+        ok = checkPhasorField() && ok;
+        ok = checkWaveSolver() && ok;
+        ok = checkShallowWater() && ok;
+    }
+    printf(ok ? "All checks passed\n" : "Some checks FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#ifndef CHECKS_H_INCLUDED
+#define CHECKS_H_INCLUDED
+
+
+// Checks of the numeric and geometric modules against references and against the properties their documentation claims
+// Built as the Checks target of the project : the program runs them with every kernel set the CPU supports, prints
+// each measure next to its bound and returns 1 if one of them is exceeded
+
+
+// Prints "name : value (bound)" and returns value <= bound, false for a NaN value
+bool checkBelow(const char *name, double value, double bound);
+
+// Approximations of exp and cos of the kernels against libm
+bool checkWaveKernels();
+// Fft2D against a naive DFT, and forward then inverse transform
+bool checkFft();
+// PhasorField against the direct sum of its CircularWaves
+bool checkPhasorField();
+// WaveEquationSolver : rest, conservation of the mean height, damping, and same heights as the scalar kernels
+bool checkWaveSolver();
+// ShallowWaterSolver : still water over a bed, conservation of the water, non negative depths, same water as the
+// scalar kernels
+bool checkShallowWater();
+// Triangle orders of the grid surface : ACMR of each one, and the same triangles with the same winding as the rows
+bool checkSurfaceOrder();
+
+
+#endif // CHECKS_H_INCLUDED
@@ -0,0 +1,80 @@
+#ifndef COLORMAPS_H_INCLUDED
+#define COLORMAPS_H_INCLUDED
+
+#include <SDL2/SDL_opengl.h>
+
+
+// Colormaps of the heights of the surface
+// A colormap is a class with a constexpr color(hauteur) : its table of COLORMAP_SIZE colors over
+// [COLORMAP_MIN_HEIGHT, COLORMAP_MAX_HEIGHT] is generated at compile time, the kernels only look it up
+enum ColormapType
+{
+    COLORMAP_SEA,      // Blue, red in the troughs and green on the crests
+    COLORMAP_DIVERGING // Blue below 0, red above, green around 0
+};
+const int COLORMAP_COUNT = 2;
+
+// Beyond the heights of the tables, the colors are those of their ends : both colormaps saturate at 12
+const float COLORMAP_MIN_HEIGHT = -12;
+const float COLORMAP_MAX_HEIGHT = 12;
+// 4 KB per table, steps of 0.02 in height : below the resolution of 8 bits colors
+const int COLORMAP_SIZE = 1024;
+
+
+// RGBA8 color packed in the memory order of GL_UNSIGNED_BYTE on a little endian CPU : red first, alpha 255
+constexpr GLuint packColor(double r, double g, double b)
+{
+    r = r < 0 ? 0 : (r > 1 ? 1 : r);
+    g = g < 0 ? 0 : (g > 1 ? 1 : g);
+    b = b < 0 ? 0 : (b > 1 ? 1 : b);
+    return GLuint(r*255 + 0.5) | GLuint(g*255 + 0.5) << 8 | GLuint(b*255 + 0.5) << 16 | 0xFF000000u;
+}
+
+
+class SeaColormap
+{
+public:
+    static constexpr GLuint color(double hauteur)
+    {
+        return packColor(-hauteur / 12, hauteur / 12, 1);
+    }
+};
+
+
+class DivergingColormap
+{
+public:
+    static constexpr GLuint color(double hauteur)
+    {
+        double vert = 0;
+        if(hauteur > -6 && hauteur <= 0) {
+            vert = hauteur / 6 + 1;
+        }
+        else if(hauteur > 0 && hauteur < 6) {
+            vert = -hauteur / 6 + 1;
+        }
+        return packColor(hauteur < 0 ? 0 : hauteur / 12, vert, hauteur > 0 ? 0 : -hauteur / 12);
+    }
+};
+
+
+// Colors of a colormap at COLORMAP_SIZE heights evenly spaced, ends included
+template<class Colormap>
+class ColormapTable
+{
+public:
+    GLuint couleurs[COLORMAP_SIZE];
+    constexpr ColormapTable() : couleurs()
+    {
+        for(int i = 0; i < COLORMAP_SIZE; i++) {
+            couleurs[i] = Colormap::color(COLORMAP_MIN_HEIGHT
+                                          + double(COLORMAP_MAX_HEIGHT - COLORMAP_MIN_HEIGHT)*i / (COLORMAP_SIZE - 1));
+        }
+    }
+};
+
+template<class Colormap>
+constexpr ColormapTable<Colormap> colormapTable = ColormapTable<Colormap>();
+
+
+#endif // COLORMAPS_H_INCLUDED
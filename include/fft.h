@@ -0,0 +1,55 @@
+#ifndef FFT_H_INCLUDED
+#define FFT_H_INCLUDED
+
+#include <vector>
+#include <SDL2/SDL_opengl.h>
+#include "threadpool.h"
+
+
+// Complex FFTs of a power of two length, computed side by side on the columns of a table :
+// column c of every row is a sample of transform c, so that every butterfly is a vector operation on a row
+// Stockham radix 4 (plus one radix 2 pass for odd powers of two) : no bit reversal, natural order output
+class BatchedFft
+{
+private:
+    int nbPoints; // Length of the transforms
+    std::vector<float> reTwiddles, imTwiddles; // w^p, w^2p, w^3p of every radix 4 pass, forward direction
+public:
+    BatchedFft(int nbPoints = 1);
+    int getNbPoints() const {return nbPoints;}
+    // Transforms the columns [debut, fin[ of the nbPoints rows of (re, im), rowStride floats apart
+    // (reTemp, imTemp) is a work table of the same size, the result is in it when isResultInTemp()
+    // The inverse transform is not normalized : the forward then inverse transforms multiply by nbPoints
+    void transform(float *re, float *im, float *reTemp, float *imTemp, int rowStride, int debut, int fin,
+                   bool inverse) const;
+    // The passes alternate between the two tables
+    bool isResultInTemp() const;
+};
+
+
+// Two dimensional FFT of n x n complex samples, n a power of two
+// The columns of the table are transformed, the table is transposed and its columns are transformed again :
+// the input is read transposed, X(kz, kx) at row kx and column kz, the output x(z, x) is at row z and column x
+// Rows are getRowStride() floats apart
+class Fft2D
+{
+private:
+    int n;
+    int rowStride; // Padded : rows a power of two apart would fall on the same cache sets
+    BatchedFft fft;
+    std::vector<float> re, im, reTemp, imTemp;
+    void transformColumns(bool inverse, ThreadPool &pool);
+    void transpose(ThreadPool &pool);
+public:
+    Fft2D(int n = 1);
+    int getSize() const {return n;}
+    int getRowStride() const {return rowStride;}
+    float* real() {return &re[0];}
+    float* imag() {return &im[0];}
+    const float* real() const {return &re[0];}
+    const float* imag() const {return &im[0];}
+    void transformTransposed(bool inverse, ThreadPool &pool);
+};
+
+
+#endif // FFT_H_INCLUDED
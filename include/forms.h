@@ -3,6 +3,15 @@
 
 #include "geometry.h"
 #include "animation.h"
+#include "heightfield.h"
+#include "threadpool.h"
+#include "waves.h"
+#include "waveregistry.h"
+#include "phasorfield.h"
+#include "wavesolver.h"
+#include "shallowwater.h"
+#include "surfaceorder.h"
+#include <functional>
 #include <vector>
 
 class Color
@@ -84,6 +93,58 @@ public:
     void render();
 };
 
+// Surface of a grid of points, two triangles per cell
+// Each point is a single vertex shared by the up to six triangles around it, the triangles only index the vertices :
+// the indices only depend on the grid size and are built once
+// Drawn by a single glDrawElements : the vertices are streamed to a buffer object every frame, the indices stay in
+// another one. Without buffer objects, the same call reads the arrays in memory
+// Positions and colors are separate arrays : the colors are written by whole vectors (ColorizeRowKernel)
+// The owner of the vertices can bring them up to date just before they are drawn (setBeforeRender)
+class SurfaceMesh : public Form
+{
+private:
+    int nbPointsX;
+    int nbPointsZ;
+    // Vertices line by line, as the points of the grid
+    std::vector<GLfloat> positions; // x, y, z
+    std::vector<GLuint> couleurs; // Packed RGBA8 (packColor)
+    std::vector<GLuint> indices; // Three per triangle
+    SurfaceOrder order;
+    GLuint vertexBuffer, indexBuffer; // 0 until the first render
+    bool indicesChanged; // Not uploaded to indexBuffer yet
+    std::function<void()> beforeRender; // Empty : the vertices are drawn as they are
+    void buildIndices();
+public:
+    SurfaceMesh(int nbPointsX = 0, int nbPointsZ = 0);
+    // The buffers need the context they were created in to be still current
+    ~SurfaceMesh();
+    SurfaceMesh(const SurfaceMesh&) = delete;
+    SurfaceMesh& operator=(const SurfaceMesh&) = delete;
+    // The indices are rebuilt only if the size changes
+    void resize(int nbPointsX, int nbPointsZ);
+    int getNbPointsX() const {return nbPointsX;}
+    int getNbPointsZ() const {return nbPointsZ;}
+    int getNbTriangles() const {return indices.size() / 3;}
+    SurfaceOrder getOrder() const {return order;}
+    // Same triangles, listed in another order
+    void setOrder(SurfaceOrder order);
+    // Vertices transformed per triangle by a FIFO cache of cacheSize vertices (see SurfaceOrder)
+    double getAcmr(int cacheSize = SURFACE_VERTEX_CACHE_SIZE) const
+    {
+        return computeAcmr(indices, nbPointsX*nbPointsZ, cacheSize);
+    }
+    // Position of the first vertex of a line, and its color
+    GLfloat* positionsRow(int ligne) {return &positions[3*ligne*nbPointsX];}
+    GLuint* couleursRow(int ligne) {return &couleurs[ligne*nbPointsX];}
+    const std::vector<GLfloat>& getPositions() const {return positions;}
+    const std::vector<GLuint>& getCouleurs() const {return couleurs;}
+    const std::vector<GLuint>& getIndices() const {return indices;}
+    // Called first by render, which then draws the vertices
+    void setBeforeRender(const std::function<void()> &callback) {beforeRender = callback;}
+    void update(double delta_t);
+    void render();
+};
+
 class Surface : public Form
 {
 private:
@@ -100,97 +161,120 @@ public:
     void render();
 };
 
-class Wave
-{
-protected:
-    Point waveOrigin;
-public:
-    //Wave(Point waveOrigin);
-
-    Point getWaveOrigin() {return waveOrigin;}
-    void setWaveOrigin(Point p) {waveOrigin = p;}
-    virtual std::vector<Point> deformGrid(std::vector<Point>) = 0;
-    virtual void updateWave(double delta_t, int nbPointsX, int nbPointsZ) = 0;
-};
-
-
-class ConicWave : public Wave
+// How the heights of a Maillage are computed
+enum SimulationMode
 {
-private:
-    GLfloat waveHeight;
-    GLfloat waveRadius;
-    Vector waveSpeed;
-    Vector waveAcceleration;
-public:
-    ConicWave(Point waveOrigin, GLfloat waveHeight, GLfloat waveRadius, Vector waveSpeed, Vector waveAcceleration);
-    GLfloat getWaveHeight() {return waveHeight;}
-    GLfloat getWaveRadius() {return waveRadius;}
-    Vector getWaveSpeed() {return waveSpeed;}
-    Vector getWaveAcceleration() {return waveAcceleration;}
-    void setWaveHeight(GLfloat h) {waveHeight = h;}
-    void setWaveRadius(GLfloat r) {waveRadius = r;}
-    void setWaveSpeed(Vector v) {waveSpeed = v;}
-    void setWaveAcceleration(Vector v) {waveSpeed = v;}
-    std::vector<Point> deformGrid(std::vector<Point>);
-    void updateWave(double delta_t, int nbPointsX, int nbPointsZ);
+    SIMULATION_ANALYTIC,     // Sum of the wave contributions, recomputed every frame
+    SIMULATION_WAVE_EQUATION, // Wave equation integrated over time, the waves being its sources
+    SIMULATION_SHALLOW_WATER  // Shallow water over the bathymetry given by the rest heights, moved by the waves
 };
 
-class CircularWave : public Wave
+// Forms of a Maillage derived from its rendered positions, rebuilt once before rendering, and only if stale
+enum MeshProduct
 {
-private:
-    GLfloat waveHeight;
-    GLfloat waveRadius;
-    GLfloat waveWidth;
-    GLfloat waveSpeed;
-    GLfloat waveAcceleration;
-public:
-    CircularWave(Point waveOrigin, GLfloat waveHeight, GLfloat waveWidth, GLfloat waveRadius, GLfloat waveSpeed, GLfloat waveAcceleration);
-    GLfloat getWaveHeight() {return waveHeight;}
-    GLfloat getWaveWidth() {return waveWidth;}
-    GLfloat getWaveRadius() {return waveRadius;}
-    GLfloat getWaveSpeed() {return waveSpeed;}
-    GLfloat getWaveAcceleration() {return waveAcceleration;}
-    void setWaveOrigin(Point p) {waveOrigin = p;}
-    void setWaveHeight(GLfloat h) {waveHeight = h;}
-    void setWaveRadius(GLfloat r) {waveRadius = r;}
-    void setWaveWidth(GLfloat w) {waveWidth = w;}
-    void setWaveSpeed(GLfloat v) {waveSpeed = v;}
-    void setWaveAcceleration(GLfloat a) {waveAcceleration = a;}
-    std::vector<Point> deformGrid(std::vector<Point>);
-    void updateWave(double delta_t, int nbPointsX, int nbPointsZ);
+    MESH_SURFACE_POSITIONS = 1,
+    MESH_SURFACE_COLORS = 2, // Colormap of the heights
+    MESH_SPHERES = 4 // Only if initSpheres created some
 };
+const int MESH_ALL_PRODUCTS = MESH_SURFACE_POSITIONS | MESH_SURFACE_COLORS | MESH_SPHERES;
 
 class Maillage : public Form
 {
 private:
-    std::vector<Wave*> waves;
-    std::vector<Point> pointsToRender;
-    std::vector<Point> basePoints;
-    std::vector<Vector> speedVectors;
-    std::vector<Vector> accelerationVectors;
+    WaveRegistry registry; // Analytic waves owned by the mesh, stored by type
+    std::vector<Wave*> waves; // Other waves, owned by the caller
+    HeightField baseField; // Rest heights of the grid, the bathymetry of the shallow water
+    HeightField field; // Heights of the simulation, deformed in place by the waves, with speeds and accelerations
+    HeightField previousField; // Positions before the last step
+    HeightField renderField; // Positions rendered, interpolated between previousField and field
+    ThreadPool *pool; // Workers deforming the field by bands of lines
+    bool fusedEvaluation; // All the waves added in a single pass over the grid
+    WaveBatch batch; // Waves of the fused pass
+    PlaneWaveTables planeTables; // Separable factors of the plane waves of the batch
+    PhasorField phasors; // Circular waves of the registry sharing a frequency, out of the batch
+    std::vector<Wave*> unbatchedWaves; // Waves without fused kernel, applied one after the other
+    SimulationMode simulationMode;
+    double time; // Seconds simulated since the creation, moved by step and seek
+    WaveEquationSolver solver;
+    ShallowWaterSolver shallowWater;
+    HeightField sourceField; // Sum of the waves, source term of the solver
     int nbPointsX;
     int nbPointsZ;
     std::vector<Sphere> spheres;
-    std::vector<Triangle> triFaces;
+    SurfaceMesh surface; // Rendered surface, rebuilt from renderField by initTriFaces
     bool colorType;
+    int staleProducts; // MeshProduct flags of the forms renderField changed since they were built
+    void initSurfacePositions();
+    void initSurfaceColors();
+    // Rebuilds the stale products
+    void refresh();
 public:
     Maillage(int nbPointsX, int nbPointsZ);
+    ~Maillage();
+    Maillage(const Maillage&) = delete;
+    Maillage& operator=(const Maillage&) = delete;
     int getNbPointsX() {return nbPointsX;};
     int getNbPointsZ() {return nbPointsZ;};
     void initControlPoints();
+    // A sphere on every rendered point : none until called, then they follow the points as the surface does
     void initSpheres();
+    // Positions and colors of the surface vertices, rebuilt now
     void initTriFaces();
-    std::vector<Point> getControlPoints() {return pointsToRender;};
-    std::vector<Vector> getSpeedVectors() {return speedVectors;};
-    std::vector<Vector> getAccelerationVectors() {return accelerationVectors;};
-    void setPointsToRender(std::vector<Point> pointsToRender);
-    void setSpeedVectors(std::vector<Vector> speedVectors);
-    void setAccelerationVectors(std::vector<Vector> AccelerationVectors);
+    // Forms to rebuild before the next render, MeshProduct flags
+    void invalidate(int products) {staleProducts |= products;}
+    int getStaleProducts() const {return staleProducts;}
+    GridView getGridView() {return field.getView();}
+    HeightField& getHeightField() {return field;}
+    const HeightField& getPreviousHeightField() const {return previousField;}
+    // Compatibility views of the height field, without copy
+    PointsView getControlPoints() const {return PointsView(field);}
+    VerticalVectorsView getSpeedVectors() const {return VerticalVectorsView(field, field.speeds());}
+    VerticalVectorsView getAccelerationVectors() const {return VerticalVectorsView(field, field.accelerations());}
+    // One point per grid point, line by line : x and z become horizontal displacements of the grid points
+    // Returns false, and changes nothing, if there is not one point per grid point
+    bool setPointsToRender(const std::vector<Point> &pointsToRender);
+    // Only the vertical components are stored : returns false, and changes nothing, if a vector has x or z
+    // components or if there is not one per point
+    // The speeds and accelerations are not rendered : they do not invalidate any form
+    bool setSpeedVectors(const std::vector<Vector> &speedVectors);
+    bool setAccelerationVectors(const std::vector<Vector> &accelerationVectors);
+    WaveRegistry& getWaves() {return registry;}
+    SurfaceMesh& getSurface() {return surface;}
+    // The mesh forgets the wave once it is retired (Wave::isRetired), the caller still owns it
     void addWave(Wave *myWave);
+    // The surface first : drawing it rebuilds the stale forms, the spheres included
     void updateFormList(Form **form_list, unsigned short *number_of_forms);
+    // Simulation step and rendering of its result
     void update(double delta_t);
+    // Simulation step only : the rendered forms are not rebuilt
+    void step(double delta_t);
+    double getTime() const {return time;}
+    // Moves every wave to its state t seconds after the creation of the mesh, in closed form, then evaluates and
+    // renders the heights as update does. Waves which can only be stepped (Wave::seek) are left as they are
+    // The solvers are not rewound : only the analytic mode is a function of the time
+    void seek(double t);
+    // Rendered positions between the states before and after the last step, alpha from 0 to 1
+    // The forms are rebuilt from them by the next render
+    void interpolate(double alpha);
+    // Same between two states given, simulated elsewhere (SimulationThread)
+    void interpolate(const HeightField &previous, const HeightField &current, double alpha);
     void render();
-    void setColorType ( bool choice) {colorType = choice;};
+    void setColorType(bool choice);
+    bool getFusedEvaluation() const {return fusedEvaluation;}
+    void setFusedEvaluation(bool fused) {fusedEvaluation = fused;}
+    SimulationMode getSimulationMode() const {return simulationMode;}
+    // The grid is put back at rest when the mode changes
+    void setSimulationMode(SimulationMode mode);
+    WaveEquationSolver& getSolver() {return solver;}
+    ShallowWaterSolver& getShallowWaterSolver() {return shallowWater;}
+    const HeightField& getBathymetry() const {return baseField;}
+    // Copies the heights of a field of the grid size as rest heights : the bed of the shallow water
+    void setBathymetry(const HeightField &bathymetry);
+    // Number of threads used by update, 0 for one per CPU core
+    int getNbThreads() const {return pool->getNbThreads();}
+    void setNbThreads(int nbThreads) {pool->setNbThreads(nbThreads);}
+    // Workers of the mesh, to be shared by the waves needing some (SpectralOceanWave)
+    ThreadPool& getThreadPool() {return *pool;}
 };
 
 
@@ -4,53 +4,69 @@
 #include <iostream>
 
 
-class Coordinates
+// The geometry is written once for any scalar type and compiled for double only (geometry.cpp) :
+// Coordinates, Point and Vector are the double precision ones
+template<class T>
+class BasicCoordinates
 {
 public:
-    double x, y, z;
-    Coordinates(double xx=0, double yy=0, double zz=0) {x=xx; y=yy; z=zz;}
+    typedef T Scalar;
+    T x, y, z;
+    BasicCoordinates(T xx=0, T yy=0, T zz=0) {x=xx; y=yy; z=zz;}
 };
 
 
 // Declaration in order to use it within Point methods
-class Vector;
+template<class T> class BasicVector;
 
-class Point : public Coordinates
+template<class T>
+class BasicPoint : public BasicCoordinates<T>
 {
 public:
     // Point constructor calls the base class constructor and do nothing more
-    Point(double xx=0, double yy=0, double zz=0) : Coordinates(xx, yy, zz) {}
-    void translate(const Vector &);
+    BasicPoint(T xx=0, T yy=0, T zz=0) : BasicCoordinates<T>(xx, yy, zz) {}
+    template<class U>
+    explicit BasicPoint(const BasicPoint<U> &p) : BasicCoordinates<T>(p.x, p.y, p.z) {}
+    void translate(const BasicVector<T> &);
 };
 
 
-class Vector : public Coordinates
+template<class T>
+class BasicVector : public BasicCoordinates<T>
 {
 public:
     // Instantiates a Vector from its coordinates
-    Vector(double xx=0, double yy=0, double zz=0) : Coordinates(xx, yy, zz) {}
+    BasicVector(T xx=0, T yy=0, T zz=0) : BasicCoordinates<T>(xx, yy, zz) {}
+    template<class U>
+    explicit BasicVector(const BasicVector<U> &v) : BasicCoordinates<T>(v.x, v.y, v.z) {}
     // Or with two points
-    Vector(Point, Point);
+    BasicVector(BasicPoint<T>, BasicPoint<T>);
     // Compute the vector norm
-    double norm();
-    Vector integral(double delta_t);
+    T norm();
+    BasicVector integral(T delta_t);
     // Overloaded standard operators
-    void operator+=(const Vector &v);
+    void operator+=(const BasicVector &v);
 };
 
 
+typedef BasicCoordinates<double> Coordinates;
+typedef BasicPoint<double> Point;
+typedef BasicVector<double> Vector;
+
+
 // Compute the distance between two points
-double distance(Point p1, Point p2);
+template<class T> T distance(BasicPoint<T> p1, BasicPoint<T> p2);
 
 // Overloaded standard operators
-std::ostream& operator<<(std::ostream& os, const Coordinates& coord);
-Vector operator+(const Vector &v1, const Vector &v2);
-Vector operator-(const Vector &v);
-Vector operator-(const Vector &v1, const Vector &v2);
-Vector operator*(const double &k, const Vector &v);
+template<class T> std::ostream& operator<<(std::ostream& os, const BasicCoordinates<T>& coord);
+template<class T> BasicVector<T> operator+(const BasicVector<T> &v1, const BasicVector<T> &v2);
+template<class T> BasicVector<T> operator-(const BasicVector<T> &v);
+template<class T> BasicVector<T> operator-(const BasicVector<T> &v1, const BasicVector<T> &v2);
+// The factor is not deduced : any number multiplies a vector of its precision
+template<class T> BasicVector<T> operator*(const typename BasicVector<T>::Scalar &k, const BasicVector<T> &v);
 // Scalar product
-double operator*(const Vector &v1, const Vector &v2);
+template<class T> T operator*(const BasicVector<T> &v1, const BasicVector<T> &v2);
 // Vector product
-Vector operator^(const Vector &v1, const Vector &v2);
+template<class T> BasicVector<T> operator^(const BasicVector<T> &v1, const BasicVector<T> &v2);
 
 #endif // GEOMETRY_H_INCLUDED
@@ -0,0 +1,24 @@
+#ifndef GLBUFFERS_H_INCLUDED
+#define GLBUFFERS_H_INCLUDED
+
+#include <SDL2/SDL_opengl.h>
+
+
+// Buffer objects of OpenGL 1.5 or GL_ARB_vertex_buffer_object, loaded at run time : the OpenGL library of Windows
+// only exports OpenGL 1.1
+class GLBufferFunctions
+{
+public:
+    PFNGLGENBUFFERSPROC genBuffers;
+    PFNGLDELETEBUFFERSPROC deleteBuffers;
+    PFNGLBINDBUFFERPROC bindBuffer;
+    PFNGLBUFFERDATAPROC bufferData;
+    PFNGLBUFFERSUBDATAPROC bufferSubData;
+};
+
+// Functions of the current context, NULL if it has no buffer objects
+// Loaded by the first call, which needs a current context
+const GLBufferFunctions* getGLBufferFunctions();
+
+
+#endif // GLBUFFERS_H_INCLUDED
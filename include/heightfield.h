@@ -0,0 +1,151 @@
+#ifndef HEIGHTFIELD_H_INCLUDED
+#define HEIGHTFIELD_H_INCLUDED
+
+#include <SDL2/SDL_opengl.h>
+#include "geometry.h"
+
+// Planes are aligned on 64 bytes and each row is padded to a multiple of 16 floats
+// => every row starts on a cache line and can be loaded with aligned SSE/AVX/AVX-512 loads
+const int HEIGHTFIELD_ALIGNMENT = 64;
+const int HEIGHTFIELD_ROW_PADDING = HEIGHTFIELD_ALIGNMENT / sizeof(GLfloat);
+
+
+// Rectangle of grid indices : lines [ligneDebut, ligneFin[ and columns [colonneDebut, colonneFin[
+class GridRect
+{
+public:
+    int ligneDebut, ligneFin;
+    int colonneDebut, colonneFin;
+    GridRect(int lDebut = 0, int lFin = 0, int cDebut = 0, int cFin = 0);
+    bool isEmpty() const {return ligneDebut >= ligneFin || colonneDebut >= colonneFin;}
+};
+
+
+// Non-owning view over a row-major grid of heights
+// The waves deform it in place, x and z are derived from the (ligne, colonne) index
+class GridView
+{
+public:
+    GLfloat *heights; // Height of point (ligne, colonne) is heights[ligne*rowStride + colonne]
+    GLfloat *displacementsX, *displacementsZ; // Horizontal displacements, same layout, NULL if the field has none
+    int nbPointsX;
+    int nbPointsZ;
+    int rowStride;
+    double originX, originZ; // Coordinates of point (0, 0)
+    double step; // Spacing between two neighbour points
+    GridView(GLfloat *h = NULL, int nbX = 0, int nbZ = 0, int stride = 0,
+             double orgX = 0, double orgZ = 0, double st = 1.0);
+    GLfloat* row(int ligne) const {return heights + ligne*rowStride;}
+    // NULL without displacement planes
+    GLfloat* rowX(int ligne) const {return displacementsX != NULL ? displacementsX + ligne*rowStride : NULL;}
+    GLfloat* rowZ(int ligne) const {return displacementsZ != NULL ? displacementsZ + ligne*rowStride : NULL;}
+    double x(int colonne) const {return originX + colonne*step;}
+    double z(int ligne) const {return originZ + ligne*step;}
+    // Columns whose x is in [xMin, xMax] (resp. lines whose z is in [zMin, zMax]),
+    // as [*debut, *fin[ clamped to the grid, empty if *debut >= *fin
+    void columnsBetween(double xMin, double xMax, int *debut, int *fin) const;
+    void linesBetween(double zMin, double zMax, int *debut, int *fin) const;
+    // Bounding rectangle of the disc of center (centreX, centreZ), visited line by line with discRowSpan
+    GridRect discRect(double centreX, double centreZ, double rayon) const;
+    // Exact chord of the disc on a line
+    void discRowSpan(double centreX, double centreZ, double rayon, int ligne, int *debut, int *fin) const;
+};
+
+
+// Structure of arrays height field on a regular grid
+// Only the heights (and optionally the vertical speeds and accelerations) are stored,
+// x and z are implicit : x = originX + colonne*step, z = originZ + ligne*step
+// Waves moving the points horizontally (GerstnerWave) need the optional displacement planes, added to x and z
+class HeightField
+{
+private:
+    int nbPointsX;
+    int nbPointsZ;
+    int rowStride;
+    double originX, originZ;
+    double step;
+    // Raw allocations and their aligned pointers, speed and acceleration planes are optional
+    GLfloat *heightStorage, *speedStorage, *accelerationStorage, *displacementXStorage, *displacementZStorage;
+    GLfloat *heightPlane, *speedPlane, *accelerationPlane, *displacementXPlane, *displacementZPlane;
+    void allocatePlane(GLfloat **storage, GLfloat **plane);
+    void copyPlane(const GLfloat *source, GLfloat **storage, GLfloat **plane);
+    void release();
+public:
+    HeightField(int nbPointsX = 0, int nbPointsZ = 0, double originX = 0, double originZ = 0, double step = 1.0);
+    HeightField(const HeightField &field);
+    HeightField& operator=(const HeightField &field);
+    ~HeightField();
+    int getNbPointsX() const {return nbPointsX;}
+    int getNbPointsZ() const {return nbPointsZ;}
+    int getRowStride() const {return rowStride;}
+    int getNbPoints() const {return nbPointsX*nbPointsZ;}
+    // Number of floats in a plane, padding included
+    int getPlaneSize() const {return rowStride*nbPointsZ;}
+    double getOriginX() const {return originX;}
+    double getOriginZ() const {return originZ;}
+    double getStep() const {return step;}
+    double x(int colonne) const {return originX + colonne*step;}
+    double z(int ligne) const {return originZ + ligne*step;}
+    int index(int ligne, int colonne) const {return ligne*rowStride + colonne;}
+
+    GLfloat* heights() {return heightPlane;}
+    const GLfloat* heights() const {return heightPlane;}
+    GLfloat* speeds() {return speedPlane;} // NULL until enableSpeeds() is called
+    const GLfloat* speeds() const {return speedPlane;}
+    GLfloat* accelerations() {return accelerationPlane;} // NULL until enableAccelerations() is called
+    const GLfloat* accelerations() const {return accelerationPlane;}
+    GLfloat* displacementsX() {return displacementXPlane;} // NULL until enableDisplacements() is called
+    const GLfloat* displacementsX() const {return displacementXPlane;}
+    GLfloat* displacementsZ() {return displacementZPlane;}
+    const GLfloat* displacementsZ() const {return displacementZPlane;}
+    void enableSpeeds();
+    void enableAccelerations();
+    void enableDisplacements();
+
+    GridView getView();
+    Point getPoint(int ligne, int colonne) const;
+    // Copies the planes of another field of the same size (no allocation)
+    void copyHeightsFrom(const HeightField &field);
+    void copyLinesFrom(const HeightField &field, int ligneDebut, int ligneFin);
+    // Heights and horizontal displacements, these only if both fields have some
+    void copyPositionsFrom(const HeightField &field);
+    // Positions previous + alpha*(current - previous) of three fields of the same size
+    void interpolatePositions(const HeightField &previous, const HeightField &current, GLfloat alpha);
+    void fill(GLfloat h);
+    void fillLines(GLfloat h, int ligneDebut, int ligneFin);
+    // Zero horizontal displacements of the lines, if the field has some
+    void clearDisplacements(int ligneDebut, int ligneFin);
+    // Zero speeds and accelerations : the field is at rest
+    void resetMotion();
+};
+
+
+// Read-only array of the points of a height field, line by line without the padding
+// Nothing is copied : each point is computed on access, from the field as it is then
+class PointsView
+{
+private:
+    const HeightField *field;
+public:
+    PointsView(const HeightField &field) {this->field = &field;}
+    int size() const {return field->getNbPoints();}
+    Point operator[](int i) const {return field->getPoint(i / field->getNbPointsX(), i % field->getNbPointsX());}
+};
+
+// Same for a plane of vertical components (speeds, accelerations) : Vector(0, value, 0)
+class VerticalVectorsView
+{
+private:
+    const HeightField *field;
+    const GLfloat *plane;
+public:
+    VerticalVectorsView(const HeightField &field, const GLfloat *plane) {this->field = &field; this->plane = plane;}
+    int size() const {return field->getNbPoints();}
+    Vector operator[](int i) const
+    {
+        return Vector(0, plane[field->index(i / field->getNbPointsX(), i % field->getNbPointsX())], 0);
+    }
+};
+
+
+#endif // HEIGHTFIELD_H_INCLUDED
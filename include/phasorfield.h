@@ -0,0 +1,83 @@
+#ifndef PHASORFIELD_H_INCLUDED
+#define PHASORFIELD_H_INCLUDED
+
+#include <vector>
+#include "heightfield.h"
+#include "threadpool.h"
+#include "waveregistry.h"
+
+
+// Groups of fewer sources do not pay for their two planes
+const int PHASOR_MIN_SOURCES = 4;
+// Radius drift, relative to the width, beyond which a wave is considered moved by hand and leaves its group
+const double PHASOR_RADIUS_TOLERANCE = 0.01;
+
+
+// CircularWaves of the same angular frequency w = pulsation * speed, summed as one complex amplitude per point :
+//   sum of height * e^(amortissement*d) * cos(pulsation*(d - radius)) = Re(A * e^(-i theta)), theta = w*t
+// A only changes where the rings grow : a frame adds the points the rings have just reached, then the heights cost
+// two multiply-adds per point and group, whatever the number of sources
+// The sources are the waves of a registry table, grouped as soon as PHASOR_MIN_SOURCES of them share a frequency
+class PhasorField
+{
+    friend class PhasorBandTask;
+private:
+    // Wave of the table as it was when it joined the group
+    class Source
+    {
+    public:
+        int handle;
+        double originX, originZ;
+        GLfloat height, width, speed, epsilon;
+        GLfloat pulsation, amortissement; // Same as the row kernels
+        double radius;     // Expected radius, moved with the speed : the wave left the group if the table disagrees
+        double phase;      // pulsation*radius - theta, constant while the wave follows the group
+        double reachAdded; // Points of the disc of this radius are in the amplitude, -1 for none
+        double reach;      // Disc of the current frame
+        bool leaving;      // Subtracted from the amplitude this frame
+    };
+
+    class Group
+    {
+    public:
+        double omega;
+        double theta; // omega*t, kept in [0, 2*pi[
+        std::vector<Source> sources;
+        HeightField re, im; // Complex amplitude A, same grid as the deformed field
+    };
+
+    std::vector<Group*> groups;
+    std::vector<int> groupOfHandle; // Group index of every table handle, -1 for none
+    std::vector<std::pair<double, int> > candidates; // Frequency and table index of the waves out of any group
+    GridView grid;
+    double lastDelta; // Time step the table was moved with since the last update
+
+    Source makeSource(const WaveTable<CircularWaveColumns> &table, int index, double theta) const;
+    bool follows(const Source &source, const WaveTable<CircularWaveColumns> &table) const;
+    void addGroup(double omega);
+    // Removes the sources which left, the empty groups, and marks the grouped waves in the table
+    void commit(WaveTable<CircularWaveColumns> &table);
+    // Adds (sign 1) or subtracts (sign -1) the amplitude of a source on the points of a line whose distance to the
+    // origin is in ]rayonDebut, rayonFin]
+    static void accumulate(Group &group, const Source &source, const GridView &grid, int ligne, double rayonDebut,
+                           double rayonFin, float sign);
+public:
+    PhasorField();
+    ~PhasorField();
+    PhasorField(const PhasorField&) = delete;
+    PhasorField& operator=(const PhasorField&) = delete;
+
+    int getNbGroups() const {return groups.size();}
+    int getNbSources() const;
+    // Drops every group, their waves go back to the batch
+    void clear(WaveTable<CircularWaveColumns> &table);
+    // Regroups the waves of the table and adds the points their rings reached since the last frame
+    // Called once per frame before the heights are deformed, delta_t being the step the table is then moved with
+    // Marks the grouped waves in the table (inPhasorField) : they must be left out of the batch
+    void update(WaveTable<CircularWaveColumns> &table, const GridView &grid, double delta_t, ThreadPool &pool);
+    // Adds the heights of every group to the lines [ligneDebut, ligneFin[ of a grid of the same size
+    void deformRows(const GridView &grid, int ligneDebut, int ligneFin) const;
+};
+
+
+#endif // PHASORFIELD_H_INCLUDED
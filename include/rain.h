@@ -0,0 +1,70 @@
+#ifndef RAIN_H_INCLUDED
+#define RAIN_H_INCLUDED
+
+#include <random>
+#include <vector>
+#include "waves.h"
+
+
+// Side of the square tiles of grid points the drops are binned in
+const int RAIN_TILE_SIZE = 32;
+// Length of the ring behind its radius, in widths : the ring of a drop is the annulus [radius - 3/2 width,
+// radius + 1/2 width], one wavelength whose cosine is 0 on both edges
+const double RAIN_RING_TRAIL = 1.5;
+
+
+// Rain falling on a grid : drops spawned at random points, each one a CircularWave ring fading with time
+// The drops live in a pool of fixed capacity : spawning and retiring a drop are O(1), nothing is allocated once the
+// tiles are warmed up
+// Every frame the drops are binned in the tiles their ring overlaps, a line then only visits the drops of its tiles
+class RainEmitter : public Wave
+{
+private:
+    GridView grid; // Geometry of the grid the drops fall on, its heights are not used
+    int capacity;
+    GLfloat rate; // Drops per second
+    GLfloat dropHeight, dropWidth, dropSpeed;
+    GLfloat dropLifetime; // Time constant of the height decay : the height is divided by e every dropLifetime
+    GLfloat epsilon; // A drop is retired once its height is below
+    double pendingDrops; // Part of a drop left to spawn by the next frame
+    int nbLost; // Drops not spawned because the pool was full
+    std::mt19937 generateur;
+
+    // Pool of the live drops [0, nbDrops[, a retired drop is replaced by the last one
+    int nbDrops;
+    std::vector<GLfloat> originX, originZ, height, radius;
+    // Kernel parameters of the live drops for the current frame, with the center, reach and inner radius of their
+    // ring in columns
+    std::vector<CircularKernelParams> params;
+    std::vector<GLfloat> inner;
+    std::vector<double> centreColonne, reachColonnes, innerColonnes;
+
+    // Drops of tile t (tile line * nbTilesX + tile column) are tileDrops[tileDebut[t]] to tileDrops[tileDebut[t+1] - 1]
+    int nbTilesX, nbTilesZ;
+    std::vector<int> tileDebut, tileCursor, tileDrops;
+
+    void spawn();
+    void retire(int drop);
+    // Calls f(tile) on every tile the ring of a drop overlaps
+    template<class F> void forEachTile(int drop, F f) const;
+    void binDrops();
+    // Adds the drops of a tile to the lines [ligneDebut, ligneFin[ and columns [colonneDebut, colonneFin[ within it
+    void deformTile(const GridView &grid, int tile, int ligneDebut, int ligneFin, int colonneDebut, int colonneFin);
+public:
+    RainEmitter(const GridView &grid, int capacity, GLfloat rate, GLfloat dropHeight = 0.3, GLfloat dropWidth = 1.5,
+                GLfloat dropSpeed = 15, GLfloat dropLifetime = 0.2, unsigned int seed = 1);
+    int getCapacity() const {return capacity;}
+    int getNbDrops() const {return nbDrops;}
+    int getNbLost() const {return nbLost;}
+    GLfloat getRate() const {return rate;}
+    void setRate(GLfloat r) {rate = r;}
+    GridRect getInfluenceRect(const GridView &grid);
+    // Tile by tile : every drop only visits the lines of its ring
+    void deformRows(const GridView &grid, int ligneDebut, int ligneFin);
+    void deformRow(const GridView &grid, int ligne, int debut, int fin);
+    // Moves and fades the drops, retires the invisible ones, spawns the new ones and bins them
+    void updateWave(double delta_t, int nbPointsX, int nbPointsZ);
+};
+
+
+#endif // RAIN_H_INCLUDED
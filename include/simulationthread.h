@@ -0,0 +1,132 @@
+#ifndef SIMULATIONTHREAD_H_INCLUDED
+#define SIMULATIONTHREAD_H_INCLUDED
+
+#include <functional>
+#include <vector>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_thread.h>
+#include "forms.h"
+#include "heightfield.h"
+#include "timestep.h"
+
+
+// Set on the index of the shared buffer when it holds a value the consumer has not taken yet
+const int TRIPLE_BUFFER_FRESH = 4;
+
+// Lock-free exchange of the latest value from one producer thread to one consumer thread
+// The producer fills the back buffer and publishes it, the consumer takes the latest published one : neither of them
+// waits, the values published in between are skipped
+template<class T>
+class TripleBuffer
+{
+private:
+    T buffers[3];
+    int back;  // Written by the producer only
+    int front; // Read by the consumer only
+    SDL_atomic_t middle; // Buffer exchanged between them, with TRIPLE_BUFFER_FRESH
+public:
+    TripleBuffer()
+    {
+        back = 0;
+        SDL_AtomicSet(&middle, 1);
+        front = 2;
+    }
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Same value in the three buffers, before the threads use them
+    void fill(const T &value)
+    {
+        for(int i = 0; i < 3; i++) {
+            buffers[i] = value;
+        }
+    }
+
+    T& getBack() {return buffers[back];}
+    void publish()
+    {
+        // The writes to the back buffer are visible before its index is
+        SDL_MemoryBarrierRelease();
+        back = SDL_AtomicSet(&middle, back | TRIPLE_BUFFER_FRESH) & ~TRIPLE_BUFFER_FRESH;
+    }
+
+    // Returns false if nothing was published since the last call : the front buffer is unchanged
+    bool acquire()
+    {
+        if(!(SDL_AtomicGet(&middle) & TRIPLE_BUFFER_FRESH)) {
+            return false;
+        }
+        // Only the consumer clears the flag : the buffer taken is fresh, maybe fresher than the one tested
+        front = SDL_AtomicSet(&middle, front) & ~TRIPLE_BUFFER_FRESH;
+        SDL_MemoryBarrierAcquire();
+        return true;
+    }
+    const T& getFront() const {return buffers[front];}
+};
+
+
+// Lock-free queue of commands of fixed capacity, from one producer thread to the consumer thread running them
+class CommandQueue
+{
+private:
+    std::vector<std::function<void()> > slots; // One slot stays empty to tell a full queue from an empty one
+    SDL_atomic_t head; // Next command to run, moved by the consumer
+    SDL_atomic_t tail; // Next free slot, moved by the producer
+public:
+    CommandQueue(int capacity = 256);
+    CommandQueue(const CommandQueue&) = delete;
+    CommandQueue& operator=(const CommandQueue&) = delete;
+    // Producer side, returns false if the queue is full
+    bool push(const std::function<void()> &command);
+    // Consumer side : runs the queued commands in order, returns their number
+    int runAll();
+};
+
+
+// State of the mesh after a simulation step, for the display
+class SimulationFrame
+{
+public:
+    HeightField previous, current; // Positions before and after the last step
+    double time; // Simulated time of current
+    double droppedTime; // Time the simulation skipped to catch up, up to current
+    SimulationFrame() {time = droppedTime = 0;}
+};
+
+
+// Simulation of a mesh on its own thread, by fixed steps : the next frame is simulated while the last one is displayed
+// The display takes the latest frame from a triple buffer and interpolates between its two states, as
+// Maillage::interpolate does. Once the thread runs, the waves, the mesh simulation and the wave kernels belong to
+// it : the other threads change them by posting commands
+class SimulationThread
+{
+private:
+    Maillage *mesh;
+    FixedTimestep timestep;
+    TripleBuffer<SimulationFrame> frames;
+    CommandQueue commands;
+    double time; // Simulated time
+    Uint64 startCounter; // Performance counter when the simulation started
+    SDL_atomic_t stopping;
+    SDL_Thread *thread;
+
+    static int threadMain(void *data);
+    void run();
+public:
+    SimulationThread(Maillage &mesh, double stepDuration = 1.0/60, int maxSteps = 5);
+    // Stops the thread, the commands not run yet are dropped
+    ~SimulationThread();
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    // Runs command on the simulation thread before its next step, returns false if the queue is full
+    bool post(const std::function<void()> &command) {return commands.push(command);}
+    // Display side : takes the latest frame, returns false if there is none since the last call
+    bool acquireFrame() {return frames.acquire();}
+    const SimulationFrame& getFrame() const {return frames.getFront();}
+    // Weight of the current positions of the frame, to display it now one step late
+    double getAlpha(const SimulationFrame &frame) const;
+};
+
+
+#endif // SIMULATIONTHREAD_H_INCLUDED
@@ -0,0 +1,54 @@
+#ifndef SPECTRALOCEAN_H_INCLUDED
+#define SPECTRALOCEAN_H_INCLUDED
+
+#include <vector>
+#include <SDL2/SDL_opengl.h>
+#include "fft.h"
+#include "threadpool.h"
+#include "waves.h"
+
+
+// Wave spectra of a wind sea, for a wind speed and direction
+enum OceanSpectrum
+{
+    OCEAN_PHILLIPS, // Tessendorf's Phillips spectrum
+    OCEAN_JONSWAP   // JONSWAP (peak enhanced Pierson-Moskowitz) with a cos^2 directional spreading
+};
+
+
+// Periodic patch of ocean synthesized from a wave spectrum (Tessendorf) : every frequency of the resolution x
+// resolution grid of wave vectors moves with the deep water dispersion, and a 2D inverse FFT gives the surface
+// The cost of a frame is O(N log N) for N = resolution^2 samples, whatever the number of spectral components
+// The patch repeats every patchSize in x and z from the wave origin, the grid samples it with bilinear interpolation
+class SpectralOceanWave : public Wave
+{
+private:
+    int resolution; // Samples per side of the patch, a power of two
+    double patchSize;
+    GLfloat significantHeight; // Mean height of the highest third of the waves (4 standard deviations)
+    ThreadPool *pool;
+    Fft2D fft; // Holds the surface of the patch between two updates : heights (real part), vertical speeds (imaginary)
+    // Spectrum, transposed for the FFT : wave vector (kx, kz) at kx*resolution + kz
+    std::vector<GLfloat> reH0, imH0, reH0Conj, imH0Conj, omega, phase;
+    void initSpectrum(double windSpeed, double windDirection, OceanSpectrum spectrum, unsigned int seed);
+    void synthesize(double delta_t);
+    GLfloat sample(const float *plane, double x, double z) const;
+public:
+    // resolution is rounded up to a power of two, windDirection is the angle of the wind with the x axis
+    SpectralOceanWave(Point waveOrigin, int resolution, double patchSize, double windSpeed, double windDirection,
+                      GLfloat significantHeight, ThreadPool &pool, OceanSpectrum spectrum = OCEAN_PHILLIPS,
+                      unsigned int seed = 1);
+    int getResolution() const {return resolution;}
+    double getPatchSize() const {return patchSize;}
+    GLfloat getSignificantHeight() const {return significantHeight;}
+    void setSignificantHeight(GLfloat h) {significantHeight = h;}
+    // Surface of the ocean at a point of the plane
+    GLfloat getHeight(double x, double z) const;
+    GLfloat getVerticalSpeed(double x, double z) const;
+    GridRect getInfluenceRect(const GridView &grid);
+    void deformRow(const GridView &grid, int ligne, int debut, int fin);
+    void updateWave(double delta_t, int nbPointsX, int nbPointsZ);
+};
+
+
+#endif // SPECTRALOCEAN_H_INCLUDED
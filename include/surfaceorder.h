@@ -0,0 +1,44 @@
+#ifndef SURFACEORDER_H_INCLUDED
+#define SURFACEORDER_H_INCLUDED
+
+#include <vector>
+#include <SDL2/SDL_opengl.h>
+
+
+// Order of the triangles of a grid surface : the same triangles, with the same winding, listed so that the vertices
+// transformed for one triangle are still in the post-transform cache for the next ones
+// ACMR (transformed vertices per triangle, FIFO of 16 vertices) on 100x100 points :
+//   rows     2.01   upper then lower triangles, line by line : every vertex is transformed about four times
+//   strips   0.58   bands of columns narrow enough for two lines of vertices to stay in the cache
+//   forsyth  0.68   greedy on any mesh, tuned for a LRU cache of 32 vertices
+// Primitive restart would need OpenGL 3.1 : the orders are lists of independent triangles
+enum SurfaceOrder
+{
+    SURFACE_ORDER_ROWS,
+    SURFACE_ORDER_STRIPS,
+    SURFACE_ORDER_FORSYTH
+};
+const int SURFACE_ORDER_COUNT = 3;
+
+// Post-transform cache assumed by the orders and by computeAcmr, in vertices
+const int SURFACE_VERTEX_CACHE_SIZE = 16;
+
+
+const char* getSurfaceOrderName(SurfaceOrder order);
+
+// Indices of the two triangles of every cell of a grid, vertices numbered line by line
+// Cell (ligne, colonne) has the triangles (ligne, colonne) (ligne, colonne+1) (ligne+1, colonne) and
+// (ligne+1, colonne) (ligne+1, colonne+1) (ligne, colonne+1)
+void buildGridIndices(std::vector<GLuint> &indices, int nbPointsX, int nbPointsZ, SurfaceOrder order,
+                      int cacheSize = SURFACE_VERTEX_CACHE_SIZE);
+
+// Greedy reordering of the triangles of any mesh for a vertex cache, after Tom Forsyth's "Linear-speed vertex cache
+// optimisation" : the next triangle is the best scored among those of the vertices in the cache
+void optimizeVertexCache(std::vector<GLuint> &indices, int nbVertices);
+
+// Average cache miss ratio : vertices transformed per triangle with a FIFO cache of cacheSize vertices
+// 3 at worst, 0.5 at best on a large grid (each vertex transformed once for two triangles)
+double computeAcmr(const std::vector<GLuint> &indices, int nbVertices, int cacheSize = SURFACE_VERTEX_CACHE_SIZE);
+
+
+#endif // SURFACEORDER_H_INCLUDED
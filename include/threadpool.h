@@ -0,0 +1,58 @@
+#ifndef THREADPOOL_H_INCLUDED
+#define THREADPOOL_H_INCLUDED
+
+#include <vector>
+#include <SDL2/SDL_atomic.h>
+#include <SDL2/SDL_mutex.h>
+#include <SDL2/SDL_thread.h>
+
+
+// Work on a band of grid lines [ligneDebut, ligneFin[
+// Bands never overlap, so a task only has to write to its own lines to be thread safe
+class RowTask
+{
+public:
+    virtual ~RowTask() {}
+    virtual void run(int ligneDebut, int ligneFin) = 0;
+};
+
+
+// Persistent pool of worker threads splitting the grid lines into bands
+// Bands are handed out in order from a shared counter (chunked scheduling) : the result
+// does not depend on the number of threads, as long as the task only writes to its own lines
+class ThreadPool
+{
+private:
+    std::vector<SDL_Thread*> workers;
+    SDL_mutex *mutex;
+    SDL_cond *workReady;
+    SDL_cond *workDone;
+    int generation; // Incremented for each parallelRows call
+    int startGeneration; // Generation when the workers were started, work posted afterwards is theirs
+    int nbActiveWorkers;
+    bool stopping;
+
+    RowTask *task;
+    int nbLignes;
+    int bandSize;
+    SDL_atomic_t nextBand;
+
+    static int workerMain(void *data);
+    void runBands();
+    void startWorkers(int nbThreads);
+    void stopWorkers();
+public:
+    // nbThreads counts the calling thread, 0 uses one thread per CPU core
+    ThreadPool(int nbThreads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    int getNbThreads() const {return workers.size() + 1;}
+    void setNbThreads(int nbThreads);
+    // Runs task on the bands of bandSize lines covering [0, nbLignes[ and returns once all are done
+    // The calling thread takes part in the work
+    void parallelRows(RowTask &task, int nbLignes, int bandSize);
+};
+
+
+#endif // THREADPOOL_H_INCLUDED
@@ -0,0 +1,33 @@
+#ifndef TIMESTEP_H_INCLUDED
+#define TIMESTEP_H_INCLUDED
+
+
+// Fixed step scheduler of the simulation, decoupled from the display
+// The real time elapsed between two frames is accumulated and simulated by steps of stepDuration : the result and
+// the stability of the simulation do not depend on the frame rate
+// The display lags one step behind and interpolates the last two states with getAlpha()
+// At most maxSteps steps are simulated per frame, the late time beyond is dropped : a frame slower than the
+// simulation does not make the next ones slower still
+class FixedTimestep
+{
+private:
+    double stepDuration; // Seconds
+    int maxSteps;
+    double accumulator; // Time elapsed and not simulated yet, less than a step after advance
+    double droppedTime; // Total time dropped by the catch-up budget
+public:
+    FixedTimestep(double stepDuration = 1.0/60, int maxSteps = 5);
+    double getStepDuration() const {return stepDuration;}
+    // The time already accumulated is kept, beyond one new step it is dropped
+    void setStepDuration(double d);
+    int getMaxSteps() const {return maxSteps;}
+    void setMaxSteps(int n) {maxSteps = n;}
+    double getDroppedTime() const {return droppedTime;}
+    // Adds the real time elapsed since the last frame, returns the number of steps to simulate now
+    int advance(double elapsed);
+    // Part of the next step already elapsed, in [0, 1] : the weight of the last state in the display
+    double getAlpha() const {return accumulator / stepDuration;}
+};
+
+
+#endif // TIMESTEP_H_INCLUDED
@@ -0,0 +1,331 @@
+#ifndef WAVEKERNELS_H_INCLUDED
+#define WAVEKERNELS_H_INCLUDED
+
+#include <vector>
+#include <SDL2/SDL_opengl.h>
+#include "colormaps.h"
+
+
+// Instruction sets the wave kernels are compiled for, from the slowest to the fastest
+enum WaveKernelIsa
+{
+    WAVE_KERNEL_SCALAR, // Reference path : double precision and libm, one point at a time
+    WAVE_KERNEL_SSE2,   // 4 points per instruction
+    WAVE_KERNEL_AVX2,   // 8 points per instruction, with FMA
+    WAVE_KERNEL_AVX512  // 16 points per instruction
+};
+const int WAVE_KERNEL_ISA_COUNT = 4;
+
+// How the SIMD kernels evaluate the transcendental functions of the circular waves, the scalar kernels always use
+// libm in double precision. Fused pass of 100 unit rings of width 4 on 1000x1000 points, one thread, and largest
+// error to the scalar kernels (265 ms) :
+//                 AVX-512   AVX2     SSE2     error
+//   exact         200 ms    200 ms   240 ms   2e-5 (float distances)
+//   polynomial     13 ms     18 ms    55 ms   2e-5 (exp and cos within 2e-7)
+//   table          11 ms     10 ms    21 ms   4e-4 (radial profiles, see CIRCULAR_PROFILE_SAMPLES)
+enum WaveMathTier
+{
+    WAVE_MATH_EXACT,      // libm, lane by lane
+    WAVE_MATH_POLYNOMIAL, // Vectorized polynomials
+    WAVE_MATH_TABLE       // Interpolated tables where the batch has some, polynomials elsewhere
+};
+const int WAVE_MATH_TIER_COUNT = 3;
+
+
+// Parameters of a ConicWave, read once per deformGrid call instead of once per point
+class ConicKernelParams
+{
+public:
+    float originX, originZ;
+    float radius;
+    float height;
+    float pente; // Cone slope |height / radius|
+    ConicKernelParams(float ox = 0, float oz = 0, float r = 1, float h = 0);
+};
+
+// Parameters of a CircularWave
+class CircularKernelParams
+{
+public:
+    float originX, originZ;
+    float radius;
+    float width;
+    float height;
+    float amortissement; // Decay coefficient applied to the distance
+    float pulsation;     // pi / width
+    // radius + width/2, or less with a cutoff : points further away are not deformed
+    // With an amplitude epsilon, the envelope height * e^(amortissement*d) is below it beyond
+    // ln(|height| / epsilon) / |amortissement| : the cutoff radius. An epsilon of 0 keeps the whole disc
+    float reach;
+    // Radial profile in the batch, -1 without : see WaveBatch::addCircular
+    int profileOffset;
+    int nbProfileSamples;
+    float profileScale; // Samples per unit of distance
+    CircularKernelParams(float ox = 0, float oz = 0, float r = 0, float w = 1, float h = 0, float epsilon = 0);
+};
+
+
+// Row kernels : add the wave contribution to hauteurs[debut..fin[ in place
+// The point of column c has x = x0 + c*step, every point of the row has the same z
+typedef void (*ConicRowKernel)(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                               const ConicKernelParams &params);
+typedef void (*CircularRowKernel)(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                                  const CircularKernelParams &params);
+
+
+// Component of a Gerstner (trochoidal) wave at the current time, for a point at (x, z) :
+//   theta = kx*x + kz*z
+//   y += Im(vertical * e^(i theta)), x += Re(horizontalX * e^(i theta)), z += Re(horizontalZ * e^(i theta))
+// The phase, time and origin are in the complex amplitudes : components of the same wave vector add up into one
+class GerstnerKernelParams
+{
+public:
+    float kx, kz;
+    float reVertical, imVertical;
+    float reHorizontalX, imHorizontalX;
+    float reHorizontalZ, imHorizontalZ;
+};
+
+
+// Plane wave at the current time : y += amplitude * cos(kx*x + kz*z + phase)
+class PlaneWaveParams
+{
+public:
+    float kx, kz;
+    float amplitude;
+    float phase; // In [0, 2*pi[, time and origin included
+};
+
+
+// Samples of a CircularWave radial profile per ring width
+// The profile h(d) = height * e^(amortissement*d) * cos(pulsation*(d - radius)) is interpolated linearly between
+// samples step = width/CIRCULAR_PROFILE_SAMPLES apart : the error is at most step^2/8 * max|h''|, with
+// |h''| <= height * (pulsation + |amortissement|)^2, that is height * (pi + 0.05*width)^2 / (8 * 64^2) :
+// 3.4e-4 * height up to a width of 4, 5.3e-4 * height up to 20
+const int CIRCULAR_PROFILE_SAMPLES = 64;
+// Rings needing more samples, far larger than the grid, are evaluated with exp and cos
+const int CIRCULAR_PROFILE_MAX_SAMPLES = 1 << 16;
+
+
+// Waves evaluated together in a single pass over the grid
+class WaveBatch
+{
+public:
+    std::vector<ConicKernelParams> conics;
+    std::vector<CircularKernelParams> circulars;
+    std::vector<GerstnerKernelParams> gerstners;
+    std::vector<PlaneWaveParams> planes;
+    std::vector<float> circularProfiles; // Radial profiles of the circular waves, one after the other
+    void clear() {conics.clear(); circulars.clear(); gerstners.clear(); planes.clear(); circularProfiles.clear();}
+    bool isEmpty() const {return conics.empty() && circulars.empty() && gerstners.empty() && planes.empty();}
+    // Samples the radial profile of the wave from its origin to its reach, once per frame : the SIMD kernels then
+    // interpolate it instead of evaluating exp and cos at every point. Only with the table tier, the scalar
+    // reference ignores it
+    void addCircular(const CircularKernelParams &params);
+    // Merged with the component of the same wave vector if there is one : its sines and cosines are shared
+    void addGerstner(const GerstnerKernelParams &component);
+};
+
+// Fused row kernel : every point of hauteurs[debut..fin[ is loaded once, the contributions of all
+// the waves of the batch crossing the row are added in registers and the result is stored once
+typedef void (*FusedRowKernel)(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                               const WaveBatch &batch);
+
+// Adds nbComponents Gerstner components to the points [debut, fin[ of a row in a single pass
+// deplacementsX and deplacementsZ may be NULL, only the heights are then deformed
+// e^(i theta) is computed once per component at the start of a tile of columns and turned from one point to the next
+typedef void (*GerstnerRowKernel)(GLfloat *hauteurs, GLfloat *deplacementsX, GLfloat *deplacementsZ, int debut, int fin,
+                                  double x0, double step, double z, const GerstnerKernelParams *components,
+                                  int nbComponents);
+
+
+// Parameters of one step of the discretized 2D wave equation, with step the grid spacing :
+//   a = c^2 * laplacian(h) - stiffness * h - damping * v + sourceGain * source, then v += a * dt
+// The stiffness pulls the surface back to rest : without it, sources of non zero mean lift the whole grid forever
+class WaveEquationParams
+{
+public:
+    float c2SurDx2; // c^2 / step^2
+    float centre;   // 4 * c^2 / step^2 + stiffness, weight of the point itself in the stencil
+    float damping;
+    float sourceGain;
+    float dt;
+    WaveEquationParams(double waveSpeed = 1, double step = 1, double stiffness = 0, double damping = 0,
+                       double sourceGain = 0, double dt = 0);
+};
+
+// Five points stencil on a line : updates the speeds and accelerations of the line from its heights and
+// the ones of the lines above and below (the line itself on a border : reflecting border)
+// sources may be NULL
+typedef void (*WaveEquationRowKernel)(GLfloat *speeds, GLfloat *accelerations, const GLfloat *hauteurs,
+                                      const GLfloat *dessus, const GLfloat *dessous, const GLfloat *sources,
+                                      int nbPoints, const WaveEquationParams &params);
+// h += v * dt on a line
+typedef void (*IntegrateRowKernel)(GLfloat *hauteurs, const GLfloat *speeds, int nbPoints, float dt);
+
+
+// One line of shallow water cells : water depth, momentum (depth * velocity) along x and z, and bed height
+class ShallowWaterRow
+{
+public:
+    const GLfloat *depth;
+    const GLfloat *momentumX;
+    const GLfloat *momentumZ;
+    const GLfloat *bed;
+};
+
+// Fluxes across a line of faces : mass, normal momentum seen by the cell before the face (gauche) and after it
+// (droite), they differ by the bed slope term, and tangential momentum
+class ShallowWaterFluxes
+{
+public:
+    GLfloat *masse;
+    GLfloat *normalGauche;
+    GLfloat *normalDroite;
+    GLfloat *tangente;
+};
+
+class ShallowWaterParams
+{
+public:
+    float gravity;
+    float dtSurDx; // dt / step
+    float dry;     // Cells with a smaller depth are dry : no velocity
+};
+
+// Fluxes across the faces between the columns debut-1..fin of a line : flux[i] is the face on the left of
+// column debut+i. The faces on the grid border are walls
+typedef void (*ShallowWaterFluxXKernel)(const ShallowWaterRow &ligne, int debut, int fin, int nbPoints,
+                                        const ShallowWaterParams &params, const ShallowWaterFluxes &flux);
+// Fluxes across the faces between two lines, for the columns debut..fin-1 : flux[i] is below column debut+i
+// On a wall, the line is given twice and the z momentum of the outer copy is negated (signe = -1)
+typedef void (*ShallowWaterFluxZKernel)(const ShallowWaterRow &haut, const ShallowWaterRow &bas, float signeHaut,
+                                        float signeBas, int debut, int fin, const ShallowWaterParams &params,
+                                        const ShallowWaterFluxes &flux);
+// Finite volume update of the cells debut..fin-1 of a line from the fluxes across their four faces, into depth,
+// momentumX and momentumZ. Returns the largest wave speed |u| + sqrt(g*h) of the new cells
+typedef float (*ShallowWaterUpdateKernel)(const ShallowWaterRow &ancien, GLfloat *depth, GLfloat *momentumX,
+                                          GLfloat *momentumZ, const ShallowWaterFluxes &x, const ShallowWaterFluxes &haut,
+                                          const ShallowWaterFluxes &bas, int debut, int fin,
+                                          const ShallowWaterParams &params);
+
+
+// Butterfly of a batched FFT : the transforms are stored side by side, column c of every row being a sample of
+// transform c. Radix 4, with a, b, c, d the input rows and sens -1 for the forward transform, 1 for the inverse :
+//   sortie[0] = (a+c) + (b+d)
+//   sortie[1] = w1 * ((a-c) + sens*i*(b-d))
+//   sortie[2] = w2 * ((a+c) - (b+d))
+//   sortie[3] = w3 * ((a-c) - sens*i*(b-d))
+// Radix 2, only the first two rows and no twiddle : sortie[0] = a+b, sortie[1] = a-b
+class FftButterfly
+{
+public:
+    const GLfloat *reEntree[4], *imEntree[4];
+    GLfloat *reSortie[4], *imSortie[4];
+    float reW[3], imW[3];
+    float sens;
+};
+typedef void (*FftButterflyKernel)(const FftButterfly &butterfly, int debut, int fin);
+
+// One row of an ocean spectrum, animated with the deep water dispersion
+class OceanSpectrumRow
+{
+public:
+    const GLfloat *reH0, *imH0;         // Amplitude h0(k) at t = 0
+    const GLfloat *reH0Conj, *imH0Conj; // conj(h0(-k))
+    const GLfloat *omega;               // Angular frequency of k
+    GLfloat *phase;                     // omega * t, kept in [0, 2*pi[
+    GLfloat *reSortie, *imSortie;       // h(k, t) + i * dh/dt(k, t)
+};
+// Advances the phases by dt and writes h(k, t) = h0(k) e^(i phase) + conj(h0(-k)) e^(-i phase) packed with its
+// time derivative : both are hermitian, so one complex inverse FFT gives the heights (real part) and the vertical
+// speeds (imaginary part)
+typedef void (*OceanSpectrumKernel)(const OceanSpectrumRow &row, int nbPoints, float dt);
+
+// Plane waves are separable on a regular grid :
+//   cos(kx*x + kz*z + phase) = cos(kx*x) cos(kz*z + phase) - sin(kx*x) sin(kz*z + phase)
+// The tables hold the column factors and the line factors of every plane wave of a batch for a grid, built with
+// (nbColonnes + nbLignes) cosines and sines per wave : the grid is then deformed with multiply-adds only
+class PlaneWaveTables
+{
+public:
+    int nbComponents, nbColonnes, nbLignes;
+    std::vector<float> cosX, sinX; // cos and sin of kx*x, wave after wave : [component*nbColonnes + colonne]
+    // amplitude * cos and -amplitude * sin of kz*z + phase, line after line : [ligne*nbComponents + component]
+    std::vector<float> coefCos, coefSin;
+    PlaneWaveTables() {nbComponents = nbColonnes = nbLignes = 0;}
+    // Sizes the tables, keeping their capacity
+    void resize(int nbComponents, int nbColonnes, int nbLignes);
+    // Fills the tables of the components [debut, fin[ for the grid of x = x0 + colonne*step, z = z0 + ligne*step
+    void build(const PlaneWaveParams *planes, int debut, int fin, double x0, double z0, double step);
+};
+
+// Adds the plane waves of the tables to the lines [ligneDebut, ligneFin[ of the grid of heights
+// The table columns are loaded once for a group of lines whose sums stay in registers
+typedef void (*PlaneWaveRowsKernel)(GLfloat *hauteurs, int rowStride, int ligneDebut, int ligneFin,
+                                    const PlaneWaveTables &tables);
+
+// Adds the real part of a complex amplitude turned by -theta to a line : h += re*cos(theta) + im*sin(theta)
+typedef void (*PhasorRowKernel)(GLfloat *hauteurs, const GLfloat *re, const GLfloat *im, int nbPoints,
+                                float cosTheta, float sinTheta);
+
+// Packed RGBA8 colors of a line of heights, one kernel per colormap : the SIMD kernels look up its table, the scalar
+// ones compute the colormap
+typedef void (*ColorizeRowKernel)(const GLfloat *hauteurs, GLuint *couleurs, int nbPoints);
+
+// exp (resp. cos) of a line with the approximations of the kernels, std::exp (resp. std::cos) for the scalar set
+// Only used to measure their error
+typedef void (*ApproxRowKernel)(const GLfloat *x, GLfloat *y, int nbPoints);
+
+class WaveKernels
+{
+public:
+    WaveKernelIsa isa;
+    WaveMathTier tier;
+    ConicRowKernel conicRow;
+    CircularRowKernel circularRow;
+    FusedRowKernel fusedRow;
+    GerstnerRowKernel gerstnerRow;
+    PlaneWaveRowsKernel planeWaveRows;
+    PhasorRowKernel phasorRow;
+    WaveEquationRowKernel waveEquationRow;
+    IntegrateRowKernel integrateRow;
+    ShallowWaterFluxXKernel shallowWaterFluxX;
+    ShallowWaterFluxZKernel shallowWaterFluxZ;
+    ShallowWaterUpdateKernel shallowWaterUpdate;
+    FftButterflyKernel fftButterfly4;
+    FftButterflyKernel fftButterfly2;
+    OceanSpectrumKernel oceanSpectrumRow;
+    ApproxRowKernel expRow;
+    ApproxRowKernel cosRow;
+};
+
+
+// Colorize kernels, apart from the wave kernels : the render thread colors the surface while the simulation thread
+// may switch the wave kernels
+class ColorizeKernels
+{
+public:
+    WaveKernelIsa isa;
+    ColorizeRowKernel colorizeRow[COLORMAP_COUNT];
+};
+
+
+// Best instruction set supported by both the build and the CPU (CPUID)
+WaveKernelIsa detectWaveKernelIsa();
+// Forces a kernel set, e.g. the scalar reference for verification
+// Returns false and keeps the current set if the CPU does not support it
+// The sets are built once and never modified : selecting publishes a pointer to one of them, so that any thread can
+// keep using the set it got. The selection itself is left to one thread (the simulation thread)
+bool selectWaveKernels(WaveKernelIsa isa);
+// Approximation tier of the kernel set, the table tier by default
+void selectWaveMathTier(WaveMathTier tier);
+// Kernels in use, the best ones are selected on first call
+const WaveKernels& getWaveKernels();
+// Colorize kernels of the best instruction set, chosen on first call and never changed
+const ColorizeKernels& getColorizeKernels();
+const char* getWaveKernelIsaName(WaveKernelIsa isa);
+const char* getWaveMathTierName(WaveMathTier tier);
+
+
+#endif // WAVEKERNELS_H_INCLUDED
@@ -0,0 +1,218 @@
+#ifndef WAVEREGISTRY_H_INCLUDED
+#define WAVEREGISTRY_H_INCLUDED
+
+#include <cassert>
+#include <vector>
+#include "waves.h"
+
+
+// Waves of one type stored densely, addressed through stable handles
+// Removing a wave moves the last one into its slot : adding and removing are O(1)
+// Columns is the structure of arrays of the type and provides :
+//   WaveType, size(), push(wave), getAt(index), setAt(index, wave), move(from, to), pop()
+template<class Columns>
+class WaveTable : public Columns
+{
+private:
+    std::vector<int> handleToIndex; // -1 for a removed wave
+    std::vector<int> indexToHandle;
+    std::vector<int> freeHandles;
+    std::vector<int> generations; // Incremented when the wave of a handle is removed, the handle may then be reused
+public:
+    typedef typename Columns::WaveType WaveType;
+
+    int add(const WaveType &wave)
+    {
+        int handle;
+        if(freeHandles.empty()) {
+            handle = handleToIndex.size();
+            handleToIndex.push_back(-1);
+            generations.push_back(0);
+        }
+        else {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        }
+        handleToIndex[handle] = Columns::size();
+        indexToHandle.push_back(handle);
+        Columns::push(wave);
+        return handle;
+    }
+
+    void remove(int handle)
+    {
+        int index = indexOf(handle);
+        int last = Columns::size() - 1;
+        if(index != last) {
+            Columns::move(last, index);
+            indexToHandle[index] = indexToHandle[last];
+            handleToIndex[indexToHandle[index]] = index;
+        }
+        Columns::pop();
+        indexToHandle.pop_back();
+        handleToIndex[handle] = -1;
+        generations[handle]++;
+        freeHandles.push_back(handle);
+    }
+
+    bool contains(int handle) const
+    {
+        return handle >= 0 && handle < int(handleToIndex.size()) && handleToIndex[handle] >= 0;
+    }
+    // The handle has to be contained : a removed wave has no index
+    int indexOf(int handle) const
+    {
+        assert(contains(handle));
+        return handleToIndex[handle];
+    }
+    int handleAt(int index) const {return indexToHandle[index];}
+    // Number of waves the handle lost : a reference also keeping it tells the wave it was made for from a later one
+    int getGeneration(int handle) const {return generations[handle];}
+    WaveType get(int handle) const {return Columns::getAt(indexOf(handle));}
+    void set(int handle, const WaveType &wave) {Columns::setAt(indexOf(handle), wave);}
+
+    void clear()
+    {
+        while(Columns::size() > 0) {
+            remove(indexToHandle.back());
+        }
+    }
+};
+
+
+// Structure of arrays of the ConicWave table, only the plane components are kept
+class ConicWaveColumns
+{
+public:
+    typedef ConicWave WaveType;
+    std::vector<double> originX, originZ;
+    std::vector<double> speedX, speedZ;
+    std::vector<double> accelerationX, accelerationZ;
+    std::vector<GLfloat> height, radius;
+
+    int size() const {return originX.size();}
+    void push(const ConicWave &wave);
+    ConicWave getAt(int index) const;
+    void setAt(int index, const ConicWave &wave);
+    void move(int from, int to);
+    void pop();
+
+    // Same physics as the ConicWave methods, looping over the whole table
+    void addToBatch(WaveBatch &batch) const;
+    void deformRows(const GridView &grid, int ligneDebut, int ligneFin) const;
+    void update(double delta_t, int nbPointsX, int nbPointsZ);
+};
+
+
+// Structure of arrays of the CircularWave table
+class CircularWaveColumns
+{
+public:
+    typedef CircularWave WaveType;
+    std::vector<double> originX, originZ;
+    std::vector<GLfloat> height, width, radius;
+    std::vector<GLfloat> speed, acceleration;
+    std::vector<GLfloat> epsilon; // Amplitude epsilon, the wave is cut off where it is smaller
+    std::vector<char> inPhasorField; // Summed by a PhasorField, left out of the batch
+
+    int size() const {return originX.size();}
+    void push(const CircularWave &wave);
+    CircularWave getAt(int index) const;
+    void setAt(int index, const CircularWave &wave);
+    void move(int from, int to);
+    void pop();
+
+    // Same physics as the CircularWave methods, looping over the whole table
+    void addToBatch(WaveBatch &batch) const;
+    void deformRows(const GridView &grid, int ligneDebut, int ligneFin) const;
+    void update(double delta_t, int nbPointsX, int nbPointsZ);
+};
+
+
+// Access to a ConicWave of a table with the ConicWave interface
+// Stays valid when other waves are added or removed. Once its own wave is removed, isValid() is false for good, even
+// if the handle goes to a new wave : check it when the wave may have been removed
+class ConicWaveRef
+{
+private:
+    WaveTable<ConicWaveColumns> *table;
+    int handle;
+    int generation;
+    int index() const {assert(isValid()); return table->indexOf(handle);}
+public:
+    ConicWaveRef(WaveTable<ConicWaveColumns> *t = NULL, int h = -1)
+    {
+        table = t;
+        handle = h;
+        generation = t != NULL ? t->getGeneration(h) : 0;
+    }
+    int getHandle() const {return handle;}
+    bool isValid() const {return table != NULL && table->contains(handle) && table->getGeneration(handle) == generation;}
+    Point getWaveOrigin() const {return Point(table->originX[index()], 0, table->originZ[index()]);}
+    GLfloat getWaveHeight() const {return table->height[index()];}
+    GLfloat getWaveRadius() const {return table->radius[index()];}
+    Vector getWaveSpeed() const {return Vector(table->speedX[index()], 0, table->speedZ[index()]);}
+    void setWaveOrigin(Point p) {table->originX[index()] = p.x; table->originZ[index()] = p.z;}
+    void setWaveHeight(GLfloat h) {table->height[index()] = h;}
+    void setWaveRadius(GLfloat r) {table->radius[index()] = r;}
+    void setWaveSpeed(Vector v) {table->speedX[index()] = v.x; table->speedZ[index()] = v.z;}
+};
+
+
+// Access to a CircularWave of a table with the CircularWave interface
+// Same validity as ConicWaveRef : Maillage retires the waves which cannot deform its grid anymore
+class CircularWaveRef
+{
+private:
+    WaveTable<CircularWaveColumns> *table;
+    int handle;
+    int generation;
+    int index() const {assert(isValid()); return table->indexOf(handle);}
+public:
+    CircularWaveRef(WaveTable<CircularWaveColumns> *t = NULL, int h = -1)
+    {
+        table = t;
+        handle = h;
+        generation = t != NULL ? t->getGeneration(h) : 0;
+    }
+    int getHandle() const {return handle;}
+    bool isValid() const {return table != NULL && table->contains(handle) && table->getGeneration(handle) == generation;}
+    Point getWaveOrigin() const {return Point(table->originX[index()], 0, table->originZ[index()]);}
+    GLfloat getWaveHeight() const {return table->height[index()];}
+    GLfloat getWaveWidth() const {return table->width[index()];}
+    GLfloat getWaveRadius() const {return table->radius[index()];}
+    GLfloat getWaveSpeed() const {return table->speed[index()];}
+    GLfloat getAmplitudeEpsilon() const {return table->epsilon[index()];}
+    void setWaveOrigin(Point p) {table->originX[index()] = p.x; table->originZ[index()] = p.z;}
+    void setWaveHeight(GLfloat h) {table->height[index()] = h;}
+    void setWaveWidth(GLfloat w) {table->width[index()] = w;}
+    void setWaveRadius(GLfloat r) {table->radius[index()] = r;}
+    void setWaveSpeed(GLfloat v) {table->speed[index()] = v;}
+    void setAmplitudeEpsilon(GLfloat e) {table->epsilon[index()] = e;}
+};
+
+
+// Owner of the analytic waves, one table per wave type
+// forEachTable calls f on every table with its exact type : no virtual call, the loops over a table can be inlined
+class WaveRegistry
+{
+public:
+    WaveTable<ConicWaveColumns> conics;
+    WaveTable<CircularWaveColumns> circulars;
+
+    ConicWaveRef addConic(const ConicWave &wave) {return ConicWaveRef(&conics, conics.add(wave));}
+    CircularWaveRef addCircular(const CircularWave &wave) {return CircularWaveRef(&circulars, circulars.add(wave));}
+    void remove(const ConicWaveRef &wave) {assert(wave.isValid()); conics.remove(wave.getHandle());}
+    void remove(const CircularWaveRef &wave) {assert(wave.isValid()); circulars.remove(wave.getHandle());}
+    // Removes the circular waves which cannot deform the grid anymore (CircularWave::isRetired) : their refs become
+    // invalid
+    void retireCirculars(const GridView &grid);
+    int size() const {return conics.size() + circulars.size();}
+    void clear() {conics.clear(); circulars.clear();}
+
+    template<class F> void forEachTable(F f) {f(conics); f(circulars);}
+    template<class F> void forEachTable(F f) const {f(conics); f(circulars);}
+};
+
+
+#endif // WAVEREGISTRY_H_INCLUDED
@@ -0,0 +1,199 @@
+#ifndef WAVES_H_INCLUDED
+#define WAVES_H_INCLUDED
+
+#include <vector>
+#include <SDL2/SDL_opengl.h>
+#include "geometry.h"
+#include "heightfield.h"
+#include "wavekernels.h"
+
+
+class Wave
+{
+protected:
+    Point waveOrigin;
+    double time; // Seconds since the creation, moved by updateWave and seek
+public:
+    //Wave(Point waveOrigin);
+    Wave() {time = 0;}
+
+    Point getWaveOrigin() const {return waveOrigin;}
+    void setWaveOrigin(Point p) {waveOrigin = p;}
+    // Rectangle of grid points the wave can deform, the whole grid by default
+    virtual GridRect getInfluenceRect(const GridView &grid);
+    // Columns [*debut, *fin[ of a line of the rectangle that the wave can deform, the whole rectangle width by default
+    virtual void getRowSpan(const GridView &grid, const GridRect &rect, int ligne, int *debut, int *fin);
+    // Adds the wave contribution to the points [debut, fin[ of a line, in place
+    virtual void deformRow(const GridView &grid, int ligne, int debut, int fin) = 0;
+    // Adds the wave contribution to the lines [ligneDebut, ligneFin[, only visiting the points it can deform
+    virtual void deformRows(const GridView &grid, int ligneDebut, int ligneFin);
+    void deformGrid(GridView grid) {deformRows(grid, 0, grid.nbPointsZ);}
+    // Adds the wave to a batch evaluated by the fused kernels, returns false if the wave has no fused kernel
+    virtual bool addToBatch(WaveBatch &) {return false;}
+    // True once the wave cannot deform the grid anymore : the mesh then forgets it
+    virtual bool isRetired(const GridView &) {return false;}
+    virtual void updateWave(double delta_t, int nbPointsX, int nbPointsZ) = 0;
+    double getTime() const {return time;}
+    // Sets the wave to its state t seconds after its creation, t of any sign and size
+    // Returns false, and leaves the wave as it is, if it can only be stepped (RainEmitter, SpectralOceanWave)
+    virtual bool seek(double, int, int) {return false;}
+};
+
+
+class ConicWave : public Wave
+{
+private:
+    GLfloat waveHeight;
+    GLfloat waveRadius;
+    Vector waveSpeed;
+    Vector waveAcceleration;
+    // State at referenceTime : the creation, or the last change of the origin, speed or height by hand
+    // The state at any time is moved from it in closed form
+    double referenceTime;
+    Point referenceOrigin;
+    Vector referenceSpeed;
+    GLfloat referenceHeight;
+    void rebase();
+public:
+    ConicWave(Point waveOrigin, GLfloat waveHeight, GLfloat waveRadius, Vector waveSpeed, Vector waveAcceleration);
+    GLfloat getWaveHeight() const {return waveHeight;}
+    GLfloat getWaveRadius() const {return waveRadius;}
+    Vector getWaveSpeed() const {return waveSpeed;}
+    Vector getWaveAcceleration() const {return waveAcceleration;}
+    void setWaveOrigin(Point p) {waveOrigin = p; rebase();}
+    void setWaveHeight(GLfloat h) {waveHeight = h; rebase();}
+    void setWaveRadius(GLfloat r) {waveRadius = r;}
+    void setWaveSpeed(Vector v) {waveSpeed = v; rebase();}
+    void setWaveAcceleration(Vector v) {waveAcceleration = v;}
+    GridRect getInfluenceRect(const GridView &grid);
+    void getRowSpan(const GridView &grid, const GridRect &rect, int ligne, int *debut, int *fin);
+    void deformRow(const GridView &grid, int ligne, int debut, int fin);
+    bool addToBatch(WaveBatch &batch);
+    void updateWave(double delta_t, int nbPointsX, int nbPointsZ);
+    // The wave t seconds after its creation, t of any sign and size : O(1), the bounces are unfolded
+    ConicWave evaluateAt(double t, int nbPointsX, int nbPointsZ) const;
+    bool seek(double t, int nbPointsX, int nbPointsZ);
+    // Moves an origin on the plane, bouncing on the grid borders and damping the height at each bounce
+    // Closed form : one step of delta_t is the same as any number of steps adding up to it
+    static void moveOrigin(double delta_t, int nbPointsX, int nbPointsZ,
+                           double &x, double &z, double &speedX, double &speedZ, GLfloat &height);
+};
+
+// Default amplitude below which a circular wave is not visible
+const GLfloat CIRCULAR_WAVE_EPSILON = 1e-3f;
+
+class CircularWave : public Wave
+{
+private:
+    GLfloat waveHeight;
+    GLfloat waveRadius;
+    GLfloat waveWidth;
+    GLfloat waveSpeed;
+    GLfloat waveAcceleration;
+    GLfloat amplitudeEpsilon; // Points where the envelope is smaller are not deformed, 0 to deform the whole disc
+    // Radius at referenceTime : the creation, or the last change of the radius or speed by hand
+    double referenceTime;
+    GLfloat referenceRadius;
+    void rebase() {referenceTime = time; referenceRadius = waveRadius;}
+    CircularKernelParams getParams() const;
+public:
+    CircularWave(Point waveOrigin, GLfloat waveHeight, GLfloat waveWidth, GLfloat waveRadius, GLfloat waveSpeed, GLfloat waveAcceleration,
+                 GLfloat amplitudeEpsilon = CIRCULAR_WAVE_EPSILON);
+    GLfloat getWaveHeight() const {return waveHeight;}
+    GLfloat getWaveWidth() const {return waveWidth;}
+    GLfloat getWaveRadius() const {return waveRadius;}
+    GLfloat getWaveSpeed() const {return waveSpeed;}
+    GLfloat getWaveAcceleration() const {return waveAcceleration;}
+    GLfloat getAmplitudeEpsilon() const {return amplitudeEpsilon;}
+    // Distance beyond which the wave is below its amplitude epsilon
+    GLfloat getCutoffRadius() const;
+    void setWaveOrigin(Point p) {waveOrigin = p;}
+    void setWaveHeight(GLfloat h) {waveHeight = h;}
+    void setWaveRadius(GLfloat r) {waveRadius = r; rebase();}
+    void setWaveWidth(GLfloat w) {waveWidth = w;}
+    void setWaveSpeed(GLfloat v) {waveSpeed = v; rebase();}
+    void setWaveAcceleration(GLfloat a) {waveAcceleration = a;}
+    void setAmplitudeEpsilon(GLfloat e) {amplitudeEpsilon = e;}
+    GridRect getInfluenceRect(const GridView &grid);
+    void getRowSpan(const GridView &grid, const GridRect &rect, int ligne, int *debut, int *fin);
+    void deformRow(const GridView &grid, int ligne, int debut, int fin);
+    bool addToBatch(WaveBatch &batch);
+    // The envelope height * e^(amortissement*d) only decays with the distance to the origin, not with the time :
+    // retired once it is below the epsilon on the grid point nearest to the origin. A wave whose origin is on the
+    // grid keeps deforming the points around it and is only retired if its height is below the epsilon
+    bool isRetired(const GridView &grid);
+    void updateWave(double delta_t, int nbPointsX, int nbPointsZ);
+    // The wave t seconds after its creation, t of any sign and size
+    CircularWave evaluateAt(double t, int nbPointsX, int nbPointsZ) const;
+    bool seek(double t, int nbPointsX, int nbPointsZ);
+};
+
+
+// Directional component of a Gerstner wave
+class GerstnerComponent
+{
+public:
+    GLfloat amplitude;
+    GLfloat wavelength;
+    GLfloat direction; // Angle of the propagation with the x axis
+    GLfloat steepness; // 0 for a sine wave, 1 for the sharpest crest a single component can have
+    GLfloat phase;
+    GerstnerComponent(GLfloat amplitude = 1, GLfloat wavelength = 10, GLfloat direction = 0, GLfloat steepness = 0.5,
+                      GLfloat phase = 0);
+};
+
+// Sum of directional trochoidal waves : the points move on circles, gathering under the crests
+// Every point is displaced in x and z too, the grid needs the displacement planes of its field for that
+// The components go with the deep water dispersion and all of them are evaluated in one pass over the grid
+class GerstnerWave : public Wave
+{
+private:
+    std::vector<GerstnerComponent> components;
+    std::vector<GerstnerKernelParams> params; // Components at the current time, merged by wave vector
+    void updateParams();
+public:
+    GerstnerWave(Point waveOrigin, const std::vector<GerstnerComponent> &components = std::vector<GerstnerComponent>());
+    const std::vector<GerstnerComponent>& getComponents() const {return components;}
+    void addComponent(const GerstnerComponent &component);
+    void clearComponents();
+    // Seconds since the creation : the surface only depends on it, any time can be set
+    void setTime(double t) {time = t; updateParams();}
+    GridRect getInfluenceRect(const GridView &grid);
+    void deformRow(const GridView &grid, int ligne, int debut, int fin);
+    bool addToBatch(WaveBatch &batch);
+    void updateWave(double delta_t, int nbPointsX, int nbPointsZ);
+    bool seek(double t, int nbPointsX, int nbPointsZ);
+};
+
+
+// Sinusoidal plane wave y += amplitude * cos(k.(p - origin) - omega*t + phase), with the deep water dispersion
+// Batched plane waves are separable on the grid : a large number of them costs multiply-adds, not cosines
+class PlaneWave : public Wave
+{
+private:
+    GLfloat amplitude;
+    GLfloat wavelength;
+    GLfloat direction; // Angle of the propagation with the x axis
+    GLfloat phase;
+    PlaneWaveParams params; // At the current time
+    void updateParams();
+public:
+    PlaneWave(Point waveOrigin, GLfloat amplitude = 1, GLfloat wavelength = 10, GLfloat direction = 0, GLfloat phase = 0);
+    GLfloat getAmplitude() const {return amplitude;}
+    GLfloat getWavelength() const {return wavelength;}
+    GLfloat getDirection() const {return direction;}
+    GLfloat getPhase() const {return phase;}
+    void setAmplitude(GLfloat a) {amplitude = a; updateParams();}
+    void setWavelength(GLfloat l) {wavelength = l; updateParams();}
+    void setDirection(GLfloat d) {direction = d; updateParams();}
+    void setPhase(GLfloat p) {phase = p; updateParams();}
+    void setTime(double t) {time = t; updateParams();}
+    GridRect getInfluenceRect(const GridView &grid);
+    void deformRow(const GridView &grid, int ligne, int debut, int fin);
+    bool addToBatch(WaveBatch &batch);
+    void updateWave(double delta_t, int nbPointsX, int nbPointsZ);
+    bool seek(double t, int nbPointsX, int nbPointsZ);
+};
+
+
+#endif // WAVES_H_INCLUDED
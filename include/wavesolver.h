@@ -0,0 +1,38 @@
+#ifndef WAVESOLVER_H_INCLUDED
+#define WAVESOLVER_H_INCLUDED
+
+#include "heightfield.h"
+#include "threadpool.h"
+
+
+// Finite difference solver of the damped 2D wave equation on a height field
+//   d2h/dt2 = c^2 * laplacian(h) - stiffness * h - damping * dh/dt + sourceGain * source
+// The laplacian is the five points stencil, the borders reflect the waves
+// Time integration is semi-implicit Euler (velocity first) : stable while c*dt/step <= 1/sqrt(2)
+class WaveEquationSolver
+{
+private:
+    double waveSpeed; // c, in grid units per second
+    double stiffness; // Pull back to rest, small compared to (c/step)^2
+    double damping;
+    double sourceGain;
+    double courant; // c*dt/step used for the sub-steps, below the 1/sqrt(2) stability limit
+public:
+    WaveEquationSolver(double waveSpeed = 20, double stiffness = 1.0, double damping = 0.3, double sourceGain = 2.0);
+    double getWaveSpeed() const {return waveSpeed;}
+    double getStiffness() const {return stiffness;}
+    double getDamping() const {return damping;}
+    double getSourceGain() const {return sourceGain;}
+    void setWaveSpeed(double c) {waveSpeed = c;}
+    void setStiffness(double k) {stiffness = k;}
+    void setDamping(double d) {damping = d;}
+    void setSourceGain(double g) {sourceGain = g;}
+    // Largest time step kept by advance on a grid of the given spacing
+    double getMaxTimeStep(double step) const;
+    // Advances the heights, speeds and accelerations of field by delta_t, in stable sub-steps
+    // field needs its speed and acceleration planes, sources has the same size as field or is NULL
+    void advance(HeightField &field, const HeightField *sources, double delta_t, ThreadPool &pool);
+};
+
+
+#endif // WAVESOLVER_H_INCLUDED
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cmath>
+#include "fft.h"
+#include "wavekernels.h"
+
+// Transforms of a task : 32 columns of a 1024 points table and its work table take 512 kB, in the L2 cache
+const int FFT_BLOCK_COLUMNS = 32;
+// Square blocks of the transposition, one cache line wide
+const int FFT_TRANSPOSE_BLOCK = 16;
+const int FFT_ROW_PADDING = 16;
+
+
+BatchedFft::BatchedFft(int nbPoints)
+{
+    this->nbPoints = nbPoints;
+
+    const double pi = 3.14159265358979323846;
+    for(int longueur = nbPoints; longueur >= 4; longueur /= 4) {
+        for(int p = 0; p < longueur/4; p++) {
+            for(int k = 1; k <= 3; k++) {
+                double angle = -2*pi*k*p / longueur;
+                reTwiddles.push_back(cos(angle));
+                imTwiddles.push_back(sin(angle));
+            }
+        }
+    }
+}
+
+
+bool BatchedFft::isResultInTemp() const
+{
+    int nbPasses = 0;
+    for(int longueur = nbPoints; longueur >= 2; longueur /= 4) {
+        nbPasses++;
+    }
+    return nbPasses % 2 == 1;
+}
+
+
+void BatchedFft::transform(float *re, float *im, float *reTemp, float *imTemp, int rowStride, int debut, int fin,
+                           bool inverse) const
+{
+    const WaveKernels &kernels = getWaveKernels();
+    float *xRe = re, *xIm = im, *yRe = reTemp, *yIm = imTemp;
+
+    FftButterfly butterfly;
+    butterfly.sens = inverse ? 1 : -1;
+
+    // Each pass reads the transforms of length longueur in x and writes 4 interleaved ones of length longueur/4 in y
+    int s = 1;
+    int twiddle = 0;
+    int longueur = nbPoints;
+    for(; longueur >= 4; longueur /= 4, s *= 4) {
+        int quart = longueur/4;
+        for(int p = 0; p < quart; p++) {
+            for(int k = 0; k < 3; k++) {
+                butterfly.reW[k] = reTwiddles[3*(twiddle + p) + k];
+                butterfly.imW[k] = inverse ? -imTwiddles[3*(twiddle + p) + k] : imTwiddles[3*(twiddle + p) + k];
+            }
+            for(int q = 0; q < s; q++) {
+                for(int k = 0; k < 4; k++) {
+                    butterfly.reEntree[k] = xRe + (q + s*(p + k*quart))*rowStride;
+                    butterfly.imEntree[k] = xIm + (q + s*(p + k*quart))*rowStride;
+                    butterfly.reSortie[k] = yRe + (q + s*(4*p + k))*rowStride;
+                    butterfly.imSortie[k] = yIm + (q + s*(4*p + k))*rowStride;
+                }
+                kernels.fftButterfly4(butterfly, debut, fin);
+            }
+        }
+        twiddle += quart;
+        std::swap(xRe, yRe);
+        std::swap(xIm, yIm);
+    }
+
+    if(longueur == 2) {
+        for(int q = 0; q < s; q++) {
+            for(int k = 0; k < 2; k++) {
+                butterfly.reEntree[k] = xRe + (q + s*k)*rowStride;
+                butterfly.imEntree[k] = xIm + (q + s*k)*rowStride;
+                butterfly.reSortie[k] = yRe + (q + s*k)*rowStride;
+                butterfly.imSortie[k] = yIm + (q + s*k)*rowStride;
+            }
+            kernels.fftButterfly2(butterfly, debut, fin);
+        }
+    }
+}
+
+
+// Transforms of the columns of a band of blocks of FFT_BLOCK_COLUMNS columns
+class FftColumnsTask : public RowTask
+{
+public:
+    const BatchedFft *fft;
+    float *re, *im, *reTemp, *imTemp;
+    int n;
+    int rowStride;
+    bool inverse;
+    void run(int blocDebut, int blocFin)
+    {
+        int debut = blocDebut*FFT_BLOCK_COLUMNS;
+        int fin = std::min(blocFin*FFT_BLOCK_COLUMNS, n);
+        for(int colonne = debut; colonne < fin; colonne += FFT_BLOCK_COLUMNS) {
+            fft->transform(re, im, reTemp, imTemp, rowStride, colonne, std::min(colonne + FFT_BLOCK_COLUMNS, fin), inverse);
+        }
+    }
+};
+
+
+// Writes the transposition of the lines of a band into the other table
+class FftTransposeTask : public RowTask
+{
+public:
+    const float *re, *im;
+    float *reT, *imT;
+    int n;
+    int rowStride;
+    void run(int ligneDebut, int ligneFin)
+    {
+        for(int colonneBloc = 0; colonneBloc < n; colonneBloc += FFT_TRANSPOSE_BLOCK) {
+            int colonneFin = std::min(colonneBloc + FFT_TRANSPOSE_BLOCK, n);
+            for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+                for(int colonne = colonneBloc; colonne < colonneFin; colonne++) {
+                    reT[colonne*rowStride + ligne] = re[ligne*rowStride + colonne];
+                    imT[colonne*rowStride + ligne] = im[ligne*rowStride + colonne];
+                }
+            }
+        }
+    }
+};
+
+
+Fft2D::Fft2D(int n) : fft(n)
+{
+    this->n = n;
+    rowStride = n + FFT_ROW_PADDING;
+    re.assign(n*rowStride, 0.0f);
+    im.assign(n*rowStride, 0.0f);
+    reTemp.assign(n*rowStride, 0.0f);
+    imTemp.assign(n*rowStride, 0.0f);
+}
+
+
+void Fft2D::transformColumns(bool inverse, ThreadPool &pool)
+{
+    FftColumnsTask task;
+    task.fft = &fft;
+    task.re = &re[0];
+    task.im = &im[0];
+    task.reTemp = &reTemp[0];
+    task.imTemp = &imTemp[0];
+    task.n = n;
+    task.rowStride = rowStride;
+    task.inverse = inverse;
+    pool.parallelRows(task, (n + FFT_BLOCK_COLUMNS - 1) / FFT_BLOCK_COLUMNS, 1);
+
+    if(fft.isResultInTemp()) {
+        re.swap(reTemp);
+        im.swap(imTemp);
+    }
+}
+
+
+void Fft2D::transpose(ThreadPool &pool)
+{
+    FftTransposeTask task;
+    task.re = &re[0];
+    task.im = &im[0];
+    task.reT = &reTemp[0];
+    task.imT = &imTemp[0];
+    task.n = n;
+    task.rowStride = rowStride;
+    pool.parallelRows(task, n, FFT_TRANSPOSE_BLOCK);
+
+    re.swap(reTemp);
+    im.swap(imTemp);
+}
+
+
+void Fft2D::transformTransposed(bool inverse, ThreadPool &pool)
+{
+    transformColumns(inverse, pool);
+    transpose(pool);
+    transformColumns(inverse, pool);
+}
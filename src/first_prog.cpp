@@ -9,6 +9,14 @@
 #include "geometry.h"
 // Module for generating and rendering forms
 #include "forms.h"
+// Vectorized wave kernels, selected from the CPU features
+#include "wavekernels.h"
+// Ocean synthesized from a wave spectrum
+#include "spectralocean.h"
+// Drops of rain, binned in tiles of the grid
+#include "rain.h"
+// Simulation on its own thread, by fixed steps
+#include "simulationthread.h"
 
 
 /***************************************************************************/
@@ -21,8 +29,12 @@ const int SCREEN_HEIGHT = 1080;
 // Max number of forms : static allocation
 const int MAX_FORMS_NUMBER = 60000;
 
-// Animation actualization delay (in ms) => 100 updates per second
-const Uint32 ANIM_DELAY = 10;
+// Simulation step (in s) => 100 updates per second, whatever the display rate
+const double SIMULATION_STEP = 0.01;
+// Steps simulated at most at once, the late time beyond is dropped
+const int MAX_CATCH_UP_STEPS = 5;
+// Display delay (in ms) => 60 frames per second
+const Uint32 FRAME_DELAY = 16;
 
 
 // Starts up SDL, creates window, and initializes OpenGL
@@ -255,7 +267,8 @@ int main(int argc, char* args[])
     {
         // Main loop flag
         bool quit = false;
-        Uint32 current_time, previous_time, elapsed_time;
+        Uint64 current_time, previous_time;
+        Uint32 frame_start;
 
         // Event handler
         SDL_Event event;
@@ -282,26 +295,49 @@ int main(int argc, char* args[])
             forms_list[i] = NULL;
         }
 
+        // Best wave kernels for this CPU, 'x' switches to the scalar reference and back
+        std::cout << "Wave kernels : " << getWaveKernelIsaName(getWaveKernels().isa) << std::endl;
+
         Maillage *pMaillage = NULL;
         pMaillage = new Maillage(100, 100);
 
-        ConicWave *pConic1 = new ConicWave(Point(7,0,2),0,10,Vector(0,0,0),Vector(0,0,0));
-        ConicWave *pConic2 = new ConicWave(Point(15,0,5),0,3,Vector(-1,0,1),Vector(0,0,0));
-        CircularWave *pCircular1 = new CircularWave(Point(0,0,0),0,30,4,10,0);
-        CircularWave *pCircular2 = new CircularWave(Point(0,0,0),0,30,4,10,0);
-        pMaillage->addWave(pCircular1);
-        pMaillage->addWave(pCircular2);
-        pMaillage->addWave(pConic1);
-        pMaillage->addWave(pConic2);
+        // The waves are owned by the mesh, the references stay valid as long as it lives
+        WaveRegistry &waves = pMaillage->getWaves();
+        CircularWaveRef circular1 = waves.addCircular(CircularWave(Point(0,0,0),0,30,4,10,0));
+        CircularWaveRef circular2 = waves.addCircular(CircularWave(Point(0,0,0),0,30,4,10,0));
+        ConicWaveRef conic1 = waves.addConic(ConicWave(Point(7,0,2),0,10,Vector(0,0,0),Vector(0,0,0)));
+        ConicWaveRef conic2 = waves.addConic(ConicWave(Point(15,0,5),0,3,Vector(-1,0,1),Vector(0,0,0)));
+        // Flat until 'n' is pressed
+        SpectralOceanWave ocean(Point(0,0,0), 128, 100, 10, 0.5, 0, pMaillage->getThreadPool());
+        pMaillage->addWave(&ocean);
+        // Sharp crested swell, no component until 'g' is pressed
+        GerstnerWave swell(Point(0,0,0));
+        pMaillage->addWave(&swell);
+        // Short crested chop of many plane waves around the wind direction, flat until 'h' is pressed
+        std::vector<PlaneWave> chop;
+        for(int i = 0; i < 64; i++) {
+            chop.push_back(PlaneWave(Point(0,0,0), 0, 3 + 0.2*i, 0.5 + 0.8*sin(2.4*i), 0.9*i));
+        }
+        for(int i = 0; i < int(chop.size()); i++) {
+            pMaillage->addWave(&chop[i]);
+        }
+        // No drop until 'j' is pressed
+        RainEmitter rain(pMaillage->getGridView(), 2000, 0);
+        pMaillage->addWave(&rain);
         pMaillage->updateFormList(forms_list, &number_of_forms);
 
+        // From now on the waves and the mesh simulation belong to the simulation thread : the keys changing them post
+        // their commands to it, the display only reads its frames
+        SimulationThread simulation(*pMaillage, SIMULATION_STEP, MAX_CATCH_UP_STEPS);
 
 
-        // Get first "current time"
-        previous_time = SDL_GetTicks();
+
+        // Get first "current time", with the high resolution counter : the millisecond ticks would make the animation jitter
+        previous_time = SDL_GetPerformanceCounter();
         // While application is running
         while(!quit)
         {
+            frame_start = SDL_GetTicks();
             // Handle events on queue
             while(SDL_PollEvent(&event) != 0)
             {
@@ -327,126 +363,138 @@ int main(int argc, char* args[])
                         break;
 
                     case SDLK_1:
-                        pConic1->setWaveOrigin(Point(0,0,0));
-                        pConic1->setWaveHeight(15);
-                        pConic1->setWaveSpeed(Vector(0,0,0));
-
-                        pConic2->setWaveOrigin(Point(0,0,0));
-                        pConic2->setWaveHeight(0);
-                        pConic2->setWaveSpeed(Vector(0,0,0));
-
-                        pCircular1->setWaveOrigin(Point(0,0,0));
-                        pCircular1->setWaveHeight(0);
-                        pCircular1->setWaveSpeed(0);
-
-                        pCircular2->setWaveOrigin(Point(0,0,0));
-                        pCircular2->setWaveHeight(0);
-                        pCircular2->setWaveSpeed(0);
+                        simulation.post([&]() {
+                            conic1.setWaveOrigin(Point(0,0,0));
+                            conic1.setWaveHeight(15);
+                            conic1.setWaveSpeed(Vector(0,0,0));
+
+                            conic2.setWaveOrigin(Point(0,0,0));
+                            conic2.setWaveHeight(0);
+                            conic2.setWaveSpeed(Vector(0,0,0));
+
+                            circular1.setWaveOrigin(Point(0,0,0));
+                            circular1.setWaveHeight(0);
+                            circular1.setWaveSpeed(0);
+
+                            circular2.setWaveOrigin(Point(0,0,0));
+                            circular2.setWaveHeight(0);
+                            circular2.setWaveSpeed(0);
+                        });
                         break;
 
                     case SDLK_2:
-                        pConic1->setWaveOrigin(Point(-20,0,-20));
-                        pConic1->setWaveHeight(15);
-                        pConic1->setWaveSpeed(Vector(5,0,5));
-
-                        pConic2->setWaveOrigin(Point(20,0,-20));
-                        pConic2->setWaveHeight(10);
-                        pConic2->setWaveSpeed(Vector(-5,0,5));
-
-                        pCircular1->setWaveOrigin(Point(0,0,0));
-                        pCircular1->setWaveHeight(0);
-                        pCircular1->setWaveSpeed(0);
-
-                        pCircular2->setWaveOrigin(Point(0,0,0));
-                        pCircular2->setWaveHeight(0);
-                        pCircular2->setWaveSpeed(0);
+                        simulation.post([&]() {
+                            conic1.setWaveOrigin(Point(-20,0,-20));
+                            conic1.setWaveHeight(15);
+                            conic1.setWaveSpeed(Vector(5,0,5));
+
+                            conic2.setWaveOrigin(Point(20,0,-20));
+                            conic2.setWaveHeight(10);
+                            conic2.setWaveSpeed(Vector(-5,0,5));
+
+                            circular1.setWaveOrigin(Point(0,0,0));
+                            circular1.setWaveHeight(0);
+                            circular1.setWaveSpeed(0);
+
+                            circular2.setWaveOrigin(Point(0,0,0));
+                            circular2.setWaveHeight(0);
+                            circular2.setWaveSpeed(0);
+                        });
                         break;
 
                     case SDLK_3:
-                        pConic1->setWaveOrigin(Point(-20,0,-20));
-                        pConic1->setWaveHeight(0);
-                        pConic1->setWaveSpeed(Vector(5,0,5));
-
-                        pConic2->setWaveOrigin(Point(20,0,-20));
-                        pConic2->setWaveHeight(0);
-                        pConic2->setWaveSpeed(Vector(-5,0,5));
-
-                        pCircular1->setWaveOrigin(Point(0,0,0));
-                        pCircular1->setWaveHeight(20);
-                        pCircular1->setWaveWidth(20);
-                        pCircular1->setWaveSpeed(10);
-                        pCircular1->setWaveRadius(0);
-
-                        pCircular2->setWaveOrigin(Point(0,0,0));
-                        pCircular2->setWaveHeight(0);
-                        pCircular2->setWaveSpeed(0);
-                        pCircular2->setWaveRadius(0);
+                        simulation.post([&]() {
+                            conic1.setWaveOrigin(Point(-20,0,-20));
+                            conic1.setWaveHeight(0);
+                            conic1.setWaveSpeed(Vector(5,0,5));
+
+                            conic2.setWaveOrigin(Point(20,0,-20));
+                            conic2.setWaveHeight(0);
+                            conic2.setWaveSpeed(Vector(-5,0,5));
+
+                            circular1.setWaveOrigin(Point(0,0,0));
+                            circular1.setWaveHeight(20);
+                            circular1.setWaveWidth(20);
+                            circular1.setWaveSpeed(10);
+                            circular1.setWaveRadius(0);
+
+                            circular2.setWaveOrigin(Point(0,0,0));
+                            circular2.setWaveHeight(0);
+                            circular2.setWaveSpeed(0);
+                            circular2.setWaveRadius(0);
+                        });
                         break;
 
 
                     case SDLK_4:
-                        pConic1->setWaveOrigin(Point(-20,0,-20));
-                        pConic1->setWaveHeight(0);
-                        pConic1->setWaveSpeed(Vector(5,0,5));
-
-                        pConic2->setWaveOrigin(Point(20,0,-20));
-                        pConic2->setWaveHeight(0);
-                        pConic2->setWaveSpeed(Vector(-5,0,5));
-
-                        pCircular1->setWaveOrigin(Point(0,0,0));
-                        pCircular1->setWaveHeight(25);
-                        pCircular1->setWaveWidth(4);
-                        pCircular1->setWaveSpeed(10);
-                        pCircular1->setWaveRadius(0);
-
-                        pCircular2->setWaveOrigin(Point(0,0,0));
-                        pCircular2->setWaveHeight(0);
-                        pCircular2->setWaveSpeed(0);
-                        pCircular2->setWaveRadius(0);
+                        simulation.post([&]() {
+                            conic1.setWaveOrigin(Point(-20,0,-20));
+                            conic1.setWaveHeight(0);
+                            conic1.setWaveSpeed(Vector(5,0,5));
+
+                            conic2.setWaveOrigin(Point(20,0,-20));
+                            conic2.setWaveHeight(0);
+                            conic2.setWaveSpeed(Vector(-5,0,5));
+
+                            circular1.setWaveOrigin(Point(0,0,0));
+                            circular1.setWaveHeight(25);
+                            circular1.setWaveWidth(4);
+                            circular1.setWaveSpeed(10);
+                            circular1.setWaveRadius(0);
+
+                            circular2.setWaveOrigin(Point(0,0,0));
+                            circular2.setWaveHeight(0);
+                            circular2.setWaveSpeed(0);
+                            circular2.setWaveRadius(0);
+                        });
                         break;
 
                     case SDLK_5:
-                        pConic1->setWaveOrigin(Point(-20,0,-20));
-                        pConic1->setWaveHeight(0);
-                        pConic1->setWaveSpeed(Vector(5,0,5));
-
-                        pConic2->setWaveOrigin(Point(20,0,-20));
-                        pConic2->setWaveHeight(0);
-                        pConic2->setWaveSpeed(Vector(-5,0,5));
-
-                        pCircular1->setWaveOrigin(Point(-15,0,0));
-                        pCircular1->setWaveHeight(15);
-                        pCircular1->setWaveSpeed(20);
-                        pCircular1->setWaveWidth(5);
-                        pCircular1->setWaveRadius(0);
-
-                        pCircular2->setWaveOrigin(Point(15,0,0));
-                        pCircular2->setWaveHeight(15);
-                        pCircular2->setWaveSpeed(20);
-                        pCircular2->setWaveWidth(5);
-                        pCircular2->setWaveRadius(0);
+                        simulation.post([&]() {
+                            conic1.setWaveOrigin(Point(-20,0,-20));
+                            conic1.setWaveHeight(0);
+                            conic1.setWaveSpeed(Vector(5,0,5));
+
+                            conic2.setWaveOrigin(Point(20,0,-20));
+                            conic2.setWaveHeight(0);
+                            conic2.setWaveSpeed(Vector(-5,0,5));
+
+                            circular1.setWaveOrigin(Point(-15,0,0));
+                            circular1.setWaveHeight(15);
+                            circular1.setWaveSpeed(20);
+                            circular1.setWaveWidth(5);
+                            circular1.setWaveRadius(0);
+
+                            circular2.setWaveOrigin(Point(15,0,0));
+                            circular2.setWaveHeight(15);
+                            circular2.setWaveSpeed(20);
+                            circular2.setWaveWidth(5);
+                            circular2.setWaveRadius(0);
+                        });
                         break;
 
                     case SDLK_6:
-                        pConic1->setWaveOrigin(Point(-20,0,-20));
-                        pConic1->setWaveHeight(20);
-                        pConic1->setWaveSpeed(Vector(9,0,4));
-
-                        pConic2->setWaveOrigin(Point(20,0,-20));
-                        pConic2->setWaveHeight(10);
-                        pConic2->setWaveSpeed(Vector(-7,0,8));
-
-                        pCircular1->setWaveOrigin(Point(-15,0,0));
-                        pCircular1->setWaveHeight(5);
-                        pCircular1->setWaveSpeed(20);
-                        pCircular1->setWaveWidth(6);
-                        pCircular1->setWaveRadius(0);
-
-                        pCircular2->setWaveOrigin(Point(15,0,0));
-                        pCircular2->setWaveHeight(4);
-                        pCircular2->setWaveSpeed(20);
-                        pCircular2->setWaveWidth(8);
-                        pCircular2->setWaveRadius(0);
+                        simulation.post([&]() {
+                            conic1.setWaveOrigin(Point(-20,0,-20));
+                            conic1.setWaveHeight(20);
+                            conic1.setWaveSpeed(Vector(9,0,4));
+
+                            conic2.setWaveOrigin(Point(20,0,-20));
+                            conic2.setWaveHeight(10);
+                            conic2.setWaveSpeed(Vector(-7,0,8));
+
+                            circular1.setWaveOrigin(Point(-15,0,0));
+                            circular1.setWaveHeight(5);
+                            circular1.setWaveSpeed(20);
+                            circular1.setWaveWidth(6);
+                            circular1.setWaveRadius(0);
+
+                            circular2.setWaveOrigin(Point(15,0,0));
+                            circular2.setWaveHeight(4);
+                            circular2.setWaveSpeed(20);
+                            circular2.setWaveWidth(8);
+                            circular2.setWaveRadius(0);
+                        });
                         break;
 
 
@@ -508,22 +556,32 @@ int main(int argc, char* args[])
                         break;
 
                     case SDLK_o:
-                        pConic1->setWaveSpeed(Vector(pConic1->getWaveSpeed().x,0,pConic1->getWaveSpeed().z-1));
+                        simulation.post([&]() {
+                            conic1.setWaveSpeed(Vector(conic1.getWaveSpeed().x,0,conic1.getWaveSpeed().z-1));
+                        });
                         break;
 
                     case SDLK_l:
-                        pConic1->setWaveSpeed(Vector(pConic1->getWaveSpeed().x,0,pConic1->getWaveSpeed().z+1));
+                        simulation.post([&]() {
+                            conic1.setWaveSpeed(Vector(conic1.getWaveSpeed().x,0,conic1.getWaveSpeed().z+1));
+                        });
                         break;
 
                     case SDLK_k:
-                        pConic1->setWaveSpeed(Vector(pConic1->getWaveSpeed().x-1,0,pConic1->getWaveSpeed().z));
+                        simulation.post([&]() {
+                            conic1.setWaveSpeed(Vector(conic1.getWaveSpeed().x-1,0,conic1.getWaveSpeed().z));
+                        });
                         break;
 
                     case SDLK_m:
-                        pConic1->setWaveSpeed(Vector(pConic1->getWaveSpeed().x+1,0,pConic1->getWaveSpeed().z));
+                        simulation.post([&]() {
+                            conic1.setWaveSpeed(Vector(conic1.getWaveSpeed().x+1,0,conic1.getWaveSpeed().z));
+                        });
                         break;
                     case SDLK_SPACE:
-                          pConic1->setWaveSpeed(Vector(0,0,0));
+                        simulation.post([&]() {
+                            conic1.setWaveSpeed(Vector(0,0,0));
+                        });
                         break;
                     case SDLK_c:
                           pMaillage->setColorType(false);
@@ -531,6 +589,78 @@ int main(int argc, char* args[])
                     case SDLK_v:
                           pMaillage->setColorType(true);
                         break;
+                    case SDLK_u:
+                    {
+                        // Next triangle order of the surface, and its vertex cache misses
+                        SurfaceMesh &surface = pMaillage->getSurface();
+                        surface.setOrder(SurfaceOrder((surface.getOrder() + 1) % SURFACE_ORDER_COUNT));
+                        std::cout << "Surface order : " << getSurfaceOrderName(surface.getOrder())
+                                  << ", ACMR " << surface.getAcmr() << std::endl;
+                        break;
+                    }
+                    case SDLK_x:
+                        simulation.post([&]() {
+                            if(getWaveKernels().isa == WAVE_KERNEL_SCALAR) {
+                                selectWaveKernels(detectWaveKernelIsa());
+                            }
+                            else {
+                                selectWaveKernels(WAVE_KERNEL_SCALAR);
+                            }
+                            std::cout << "Wave kernels : " << getWaveKernelIsaName(getWaveKernels().isa) << std::endl;
+                        });
+                        break;
+                    case SDLK_b:
+                        simulation.post([&]() {
+                            // exact, polynomial, table, exact...
+                            selectWaveMathTier(WaveMathTier((getWaveKernels().tier + 1) % WAVE_MATH_TIER_COUNT));
+                            std::cout << "Wave math : " << getWaveMathTierName(getWaveKernels().tier) << std::endl;
+                        });
+                        break;
+                    case SDLK_g:
+                        simulation.post([&]() {
+                            if(swell.getComponents().empty()) {
+                                swell.addComponent(GerstnerComponent(1.5, 25, 0.3, 0.7, 0));
+                                swell.addComponent(GerstnerComponent(0.8, 13, 0.9, 0.6, 1.3));
+                                swell.addComponent(GerstnerComponent(0.4, 7, -0.4, 0.5, 2.1));
+                            }
+                            else {
+                                swell.clearComponents();
+                            }
+                        });
+                        break;
+                    case SDLK_h:
+                        simulation.post([&]() {
+                            for(int i = 0; i < int(chop.size()); i++) {
+                                chop[i].setAmplitude(chop[i].getAmplitude() == 0 ? 0.05 : 0);
+                            }
+                        });
+                        break;
+                    case SDLK_j:
+                        simulation.post([&]() {
+                            rain.setRate(rain.getRate() == 0 ? 200 : 0);
+                        });
+                        break;
+                    case SDLK_n:
+                        simulation.post([&]() {
+                            ocean.setSignificantHeight(ocean.getSignificantHeight() == 0 ? 3 : 0);
+                        });
+                        break;
+                    case SDLK_p:
+                        simulation.post([&]() {
+                            if(pMaillage->getSimulationMode() == SIMULATION_ANALYTIC) {
+                                pMaillage->setSimulationMode(SIMULATION_WAVE_EQUATION);
+                                std::cout << "Simulation : wave equation" << std::endl;
+                            }
+                            else if(pMaillage->getSimulationMode() == SIMULATION_WAVE_EQUATION) {
+                                pMaillage->setSimulationMode(SIMULATION_SHALLOW_WATER);
+                                std::cout << "Simulation : shallow water" << std::endl;
+                            }
+                            else {
+                                pMaillage->setSimulationMode(SIMULATION_ANALYTIC);
+                                std::cout << "Simulation : analytic" << std::endl;
+                            }
+                        });
+                        break;
                     default:
 
                         break;
@@ -542,14 +672,13 @@ int main(int argc, char* args[])
             }
 
             // Update the scene
-            current_time = SDL_GetTicks(); // get the elapsed time from SDL initialization (ms)
-            elapsed_time = current_time - previous_time;
-            if (elapsed_time > ANIM_DELAY)
-            {
-                previous_time = current_time;
-                update(forms_list, 1e-3 * elapsed_time); // International system units : seconds
-                pMaillage->update(1e-3 * elapsed_time);
-            }
+            current_time = SDL_GetPerformanceCounter();
+            update(forms_list, double(current_time - previous_time) / SDL_GetPerformanceFrequency()); // International system units : seconds
+            previous_time = current_time;
+            // Latest frame simulated, displayed between its two steps
+            simulation.acquireFrame();
+            const SimulationFrame &frame = simulation.getFrame();
+            pMaillage->interpolate(frame.previous, frame.current, simulation.getAlpha(frame));
 
             // Render the scene
             camera_position = Point(xcam, ycam, zcam);
@@ -558,6 +687,13 @@ int main(int argc, char* args[])
 
             // Update window screen
             SDL_GL_SwapWindow(gWindow);
+
+            // Waiting for the next frame rather than rendering as fast as possible
+            Uint32 frame_time = SDL_GetTicks() - frame_start;
+            if(frame_time < FRAME_DELAY)
+            {
+                SDL_Delay(FRAME_DELAY - frame_time);
+            }
         }
     }
 
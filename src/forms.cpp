@@ -1,7 +1,9 @@
+#include <algorithm>
 #include <cmath>
 #include <SDL2/SDL_opengl.h>
 #include <GL/GLU.h>
 #include "forms.h"
+#include "glbuffers.h"
 
 
 void Form::update(double delta_t)
@@ -139,6 +141,115 @@ void Triangle::render()
     glEnd();
 }
 
+SurfaceMesh::SurfaceMesh(int nbPointsX, int nbPointsZ)
+{
+    this->nbPointsX = this->nbPointsZ = 0;
+    order = SURFACE_ORDER_STRIPS;
+    vertexBuffer = indexBuffer = 0;
+    resize(nbPointsX, nbPointsZ);
+}
+
+
+SurfaceMesh::~SurfaceMesh()
+{
+    const GLBufferFunctions *gl = getGLBufferFunctions();
+    if(vertexBuffer != 0 && gl != NULL) {
+        GLuint buffers[2] = {vertexBuffer, indexBuffer};
+        gl->deleteBuffers(2, buffers);
+    }
+}
+
+
+void SurfaceMesh::resize(int nbPointsX, int nbPointsZ)
+{
+    if(nbPointsX == this->nbPointsX && nbPointsZ == this->nbPointsZ) {
+        return;
+    }
+    this->nbPointsX = nbPointsX;
+    this->nbPointsZ = nbPointsZ;
+    positions.assign(3*nbPointsX*nbPointsZ, 0.0f);
+    couleurs.assign(nbPointsX*nbPointsZ, packColor(1, 1, 1));
+    buildIndices();
+}
+
+
+void SurfaceMesh::buildIndices()
+{
+    buildGridIndices(indices, nbPointsX, nbPointsZ, order);
+    indicesChanged = true;
+}
+
+
+void SurfaceMesh::setOrder(SurfaceOrder order)
+{
+    if(order != this->order) {
+        this->order = order;
+        buildIndices();
+    }
+}
+
+
+void SurfaceMesh::update(double)
+{
+    // The vertices are set by their owner
+}
+
+
+void SurfaceMesh::render()
+{
+    if(beforeRender) {
+        beforeRender();
+    }
+    if(indices.empty()) {
+        return;
+    }
+    const GLvoid *sommets = positions.data();
+    const GLvoid *teintes = couleurs.data();
+    const GLvoid *indexes = indices.data();
+    const GLBufferFunctions *gl = getGLBufferFunctions();
+    if(gl != NULL) {
+        if(vertexBuffer == 0) {
+            GLuint buffers[2];
+            gl->genBuffers(2, buffers);
+            vertexBuffer = buffers[0];
+            indexBuffer = buffers[1];
+            indicesChanged = true;
+        }
+        // Orphaning : the vertices of the frame go to a new storage, the driver keeps the previous one as long as a
+        // draw still reads it, instead of waiting for it
+        gl->bindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        // The colors follow the positions in the buffer
+        GLsizeiptr taillePositions = positions.size()*sizeof(GLfloat);
+        GLsizeiptr tailleCouleurs = couleurs.size()*sizeof(GLuint);
+        gl->bufferData(GL_ARRAY_BUFFER, taillePositions + tailleCouleurs, NULL, GL_STREAM_DRAW);
+        gl->bufferSubData(GL_ARRAY_BUFFER, 0, taillePositions, positions.data());
+        gl->bufferSubData(GL_ARRAY_BUFFER, taillePositions, tailleCouleurs, couleurs.data());
+        gl->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+        if(indicesChanged) {
+            gl->bufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+            indicesChanged = false;
+        }
+        // Offsets in the buffers
+        sommets = NULL;
+        teintes = (const GLubyte*)NULL + taillePositions;
+        indexes = NULL;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, sommets);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, teintes);
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, indexes);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    if(gl != NULL) {
+        // The other forms draw from memory
+        gl->bindBuffer(GL_ARRAY_BUFFER, 0);
+        gl->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
 Surface::Surface(GLfloat *points, int nbPointsX, int nbPointsZ)
 {
     //Allocate 3d array of correct size
@@ -249,359 +360,387 @@ Maillage::Maillage(int nbPointsX, int nbPointsZ)
     this->nbPointsX = nbPointsX;
     this->nbPointsZ = nbPointsZ;
 
+    pool = new ThreadPool();
+    fusedEvaluation = true;
+    simulationMode = SIMULATION_ANALYTIC;
+    time = 0;
+
     initControlPoints();
     //initSpheres();
-    initTriFaces();
     this->colorType = false;
+    surface.resize(nbPointsX, nbPointsZ);
+    // The surface is built by its first render, wherever it is rendered from
+    staleProducts = MESH_ALL_PRODUCTS;
+    surface.setBeforeRender([this]() {refresh();});
+}
+
+Maillage::~Maillage()
+{
+    delete pool;
 }
 
 void Maillage::updateFormList(Form **form_list, unsigned short *number_of_forms) {
+    // The whole surface is a single form
+    form_list[*number_of_forms]=&surface;
+    *number_of_forms = *number_of_forms+1;
     for(int i = 0; i < this->spheres.size(); i++) {
         Sphere *pSphere = NULL;
         pSphere = &spheres[i];
         form_list[*number_of_forms]=pSphere;
         *number_of_forms = *number_of_forms+1;
     }
-    for(int i = 0; i < this->triFaces.size(); i++) {
-        Triangle *pTriangle = NULL;
-        pTriangle = &triFaces[i];
-        form_list[*number_of_forms]=pTriangle;
-        *number_of_forms = *number_of_forms+1;
-    }
 }
 
 void Maillage::initControlPoints() {
-    //Flat plane of control points
-    {
-    for (int i =-(0.5*nbPointsZ) ; i < 0.5*nbPointsZ ; i++) { // On it�re les lignes
-        for (int j = -(0.5*nbPointsX); j < 0.5*nbPointsX; j++) { // On it�re les valeurs des lignes
-            Point monPoint = Point(j, 0, i);
-            basePoints.push_back(monPoint);
-        }
-    }
-    }
-
-    pointsToRender = basePoints;
+    //Flat plane of control points, centered on the origin, one unit apart
+    //First point is (-(0.5*nbPointsX), 0, -(0.5*nbPointsZ)) truncated as integers
+    int premiereColonne = -(0.5*nbPointsX);
+    int premiereLigne = -(0.5*nbPointsZ);
+    baseField = HeightField(nbPointsX, nbPointsZ, premiereColonne, premiereLigne, 1.0);
+
+    field = baseField;
+
+    // Null speed and acceleration vectors, and no horizontal displacement
+    field.enableSpeeds();
+    field.enableAccelerations();
+    field.enableDisplacements();
+    previousField = renderField = field;
+}
 
-    // Null speed vectors
-    {
-    for (int i = 0; i < nbPointsZ; i++) { // On it�re les lignes
-        for (int j = 0; j < nbPointsX; j++) { // On it�re les valeurs des lignes
-            Vector monVecteur = Vector(0,0,0);
-            speedVectors.push_back(monVecteur);
-        }
+bool Maillage::setPointsToRender(const std::vector<Point> &pointsToRender) {
+    if(int(pointsToRender.size()) != field.getNbPoints()) {
+        return false;
     }
+    // Rendered as they are, until the next interpolate
+    // x and z are kept as horizontal displacements from the grid point
+    for(int ligne = 0; ligne < nbPointsZ; ligne ++) {
+        for(int colonne = 0; colonne < nbPointsX; colonne++) {
+            const Point &point = pointsToRender[ligne*nbPointsX + colonne];
+            int i = field.index(ligne, colonne);
+            field.heights()[i] = renderField.heights()[i] = point.y;
+            if(field.displacementsX() != NULL) {
+                field.displacementsX()[i] = renderField.displacementsX()[i] = point.x - field.x(colonne);
+                field.displacementsZ()[i] = renderField.displacementsZ()[i] = point.z - field.z(ligne);
+            }
+        }
     }
+    invalidate(MESH_ALL_PRODUCTS);
+    return true;
+}
 
-    // Null acceleration vectors
-    {
-    for (int i = 0; i < nbPointsZ; i++) { // On it�re les lignes
-        for (int j = 0; j < nbPointsX; j++) { // On it�re les valeurs des lignes
-            Vector monVecteur = Vector(0,0,0);
-            accelerationVectors.push_back(monVecteur);
-        }
+// One vector per point, all vertical : the only ones the speed and acceleration planes can store
+static bool areVerticalVectors(const std::vector<Vector> &vectors, int nbPoints)
+{
+    if(int(vectors.size()) != nbPoints) {
+        return false;
     }
+    for(int i = 0; i < nbPoints; i++) {
+        if(vectors[i].x != 0 || vectors[i].z != 0) {
+            return false;
+        }
     }
+    return true;
 }
 
-void Maillage::setPointsToRender(std::vector<Point> pointsToRender) {
-    this->pointsToRender=pointsToRender;
-    this->initSpheres();
-    this->initTriFaces();
+bool Maillage::setSpeedVectors(const std::vector<Vector> &speedVectors) {
+    if(!areVerticalVectors(speedVectors, field.getNbPoints())) {
+        return false;
+    }
+    for(int ligne = 0; ligne < nbPointsZ; ligne ++) {
+        for(int colonne = 0; colonne < nbPointsX; colonne++) {
+            field.speeds()[field.index(ligne, colonne)] = speedVectors[ligne*nbPointsX + colonne].y;
+        }
+    }
+    return true;
 }
 
-void Maillage::setSpeedVectors(std::vector<Vector> speedVectors) {
-    this->speedVectors=speedVectors;
-    this->initSpheres();
-    this->initTriFaces();
+bool Maillage::setAccelerationVectors(const std::vector<Vector> &accelerationVectors) {
+    if(!areVerticalVectors(accelerationVectors, field.getNbPoints())) {
+        return false;
+    }
+    for(int ligne = 0; ligne < nbPointsZ; ligne ++) {
+        for(int colonne = 0; colonne < nbPointsX; colonne++) {
+            field.accelerations()[field.index(ligne, colonne)] = accelerationVectors[ligne*nbPointsX + colonne].y;
+        }
+    }
+    return true;
 }
 
-void Maillage::setAccelerationVectors(std::vector<Vector> accelerationVectors) {
-    this->accelerationVectors=accelerationVectors;
-    this->initSpheres();
-    this->initTriFaces();
+void Maillage::setColorType(bool choice) {
+    if(choice != colorType) {
+        colorType = choice;
+        invalidate(MESH_SURFACE_COLORS);
+    }
 }
 
 void Maillage::initSpheres() {
-    this->spheres.clear();
-
-    //Creating a sphere for each control point
-    for(int ligne = 0; ligne < nbPointsZ; ligne ++) { // On it�re les lignes
-        for(int colonne = 0; colonne < nbPointsX; colonne++) { // On it�re les valeurs des lignes
-            // Origine
-            Point Origine = pointsToRender[ligne*nbPointsX + colonne];
-
-            //Sphere
-            Sphere sphere = Sphere(0.1, DODGERBLUE);
-            sphere.getAnim().setPos(Origine);
-
-            this->spheres.push_back(sphere);
+    //Creating a sphere for each control point, moved in place once created : the form list keeps their addresses
+    if(int(this->spheres.size()) != renderField.getNbPoints()) {
+        this->spheres.assign(renderField.getNbPoints(), Sphere(0.1, DODGERBLUE));
+    }
+    for(int ligne = 0; ligne < nbPointsZ; ligne ++) { // On itère les lignes
+        for(int colonne = 0; colonne < nbPointsX; colonne++) { // On itère les valeurs des lignes
+            this->spheres[ligne*nbPointsX + colonne].getAnim().setPos(renderField.getPoint(ligne, colonne));
         }
     }
+    staleProducts &= ~MESH_SPHERES;
 }
 
 void Maillage::initTriFaces() {
-    double moyenne_hauteur = 0;
-    Color couleur;
-    double ymax =12;
-    double ab = -1/ymax;//1/(2*ymax);
-    double bb =0;// 0.5;
-
-    double ag = 2/ymax;//1/ymax;
-    double bg= 1;//0;
-
-    double ar = 1/ymax;//-1/ymax;
-    double br= 0;
-    float maximum;
-    this->triFaces.clear();
-
-    //Upper triFaces
-    for(int ligne = 0; ligne < nbPointsZ; ligne ++) { // On it�re les lignes
-        for(int colonne = 0; colonne < nbPointsX; colonne++) { // On it�re les valeurs des lignes
-            if(colonne < nbPointsX-1 && ligne < nbPointsZ-1) { // On ne fait pas de surface � partir du bord droit et bas
-                // Origine
-                Point Origine = pointsToRender[ligne*nbPointsX + colonne];
-                // Point X
-                Point PointX1 = pointsToRender[ligne*nbPointsX + colonne+1];
-                //Point Z
-                Point PointZ1 = pointsToRender[(ligne+1)*nbPointsX + colonne];
-
-                maximum = std::max(std::max(Origine.y,PointX1.y),PointZ1.y);
-
-                moyenne_hauteur = maximum;
-                moyenne_hauteur = (Origine.y+PointX1.y+PointZ1.y)/3;
-
-                if (colorType == 0){
-
-                    couleur.b= 1;
-                    couleur.r = (-1/ymax)*moyenne_hauteur;
-                    if (couleur.r> 1){
-                            couleur.r=1;
-                    }
-                    else if (couleur.r<0){
-                        couleur.r = 0;
-                    }
-                    couleur.g = (1/ymax)*moyenne_hauteur;
-                    if (couleur.g> 1){
-                            couleur.g=1;
-                    }
-                    else if (couleur.g<0){
-                        couleur.g = 0;
-                    }
-                }
-                else{
-
-                    //Bleu
-                    couleur.b= (-1/ymax)*moyenne_hauteur;
-                    if (moyenne_hauteur > 0){
-                            couleur.b = 0;
-                    }
-
-                    //Rouge
-                    couleur.r = (1/ymax)*moyenne_hauteur;
-                    if (moyenne_hauteur < 0){
-                        couleur.r = 0;
-                    }
-
-                    //Vert
-                    if ( moyenne_hauteur > -ymax/2 && moyenne_hauteur <= 0){
-                        couleur.g = (2/ymax)*moyenne_hauteur+1;
-                    }
-                    else if (moyenne_hauteur > 0 && moyenne_hauteur < ymax/2){
-                        couleur.g = (-2/ymax)*moyenne_hauteur+1;
-                    }
-                    else {couleur.g = 0;}
-
-                }
-
-
-                //Triangle face
-                Triangle face = Triangle(Origine, PointX1, PointZ1, couleur);
-
-                this->triFaces.push_back(face);
+    initSurfacePositions();
+    initSurfaceColors();
+}
+
+void Maillage::initSurfacePositions() {
+    GridView grid = renderField.getView();
+    for(int ligne = 0; ligne < nbPointsZ; ligne ++) { // On itère les lignes
+        GLfloat *position = surface.positionsRow(ligne);
+        const GLfloat *hauteurs = grid.row(ligne);
+        const GLfloat *deplacementsX = grid.rowX(ligne);
+        const GLfloat *deplacementsZ = grid.rowZ(ligne);
+        for(int colonne = 0; colonne < nbPointsX; colonne++) { // On itère les valeurs des lignes
+            position[3*colonne] = grid.x(colonne);
+            position[3*colonne + 1] = hauteurs[colonne];
+            position[3*colonne + 2] = grid.z(ligne);
+        }
+        if(deplacementsX != NULL) {
+            for(int colonne = 0; colonne < nbPointsX; colonne++) {
+                position[3*colonne] += deplacementsX[colonne];
+                position[3*colonne + 2] += deplacementsZ[colonne];
             }
         }
     }
+    staleProducts &= ~MESH_SURFACE_POSITIONS;
+}
 
-    //Lower triFaces
-    for(int ligne = 0; ligne < nbPointsZ; ligne ++) { // On it�re les lignes
-        for(int colonne = 0; colonne < nbPointsX; colonne++) { // On it�re les valeurs des lignes
-            if(colonne < nbPointsX-1 && ligne != 0) { // On ne fait pas de surface � partir du bord haut et droit
-                // Origine
-                Point Origine = pointsToRender[ligne*nbPointsX + colonne];
-                // Point X
-                Point PointX1 = pointsToRender[ligne*nbPointsX + colonne+1];
-                //Point Z
-                Point PointZ1 = pointsToRender[(ligne-1)*nbPointsX + colonne+1];
-
-               maximum = std::max(std::max(Origine.y,PointX1.y),PointZ1.y);
-
-                moyenne_hauteur = maximum;
-                moyenne_hauteur = (Origine.y+PointX1.y+PointZ1.y)/3;
-if (colorType == 0){
-
-                    couleur.b= 1;
-                    couleur.r = (-1/ymax)*moyenne_hauteur;
-                    if (couleur.r> 1){
-                            couleur.r=1;
-                    }
-                    else if (couleur.r<0){
-                        couleur.r = 0;
-                    }
-                    couleur.g = (1/ymax)*moyenne_hauteur;
-                    if (couleur.g> 1){
-                            couleur.g=1;
-                    }
-                    else if (couleur.g<0){
-                        couleur.g = 0;
-                    }
-                }
-                else{
-
-                    //Bleu
-                    couleur.b= (-1/ymax)*moyenne_hauteur;
-                    if (moyenne_hauteur > 0){
-                            couleur.b = 0;
-                    }
-
-                    //Rouge
-                    couleur.r = (1/ymax)*moyenne_hauteur;
-                    if (moyenne_hauteur < 0){
-                        couleur.r = 0;
-                    }
-
-                    //Vert
-                    if ( moyenne_hauteur > -ymax/2 && moyenne_hauteur <= 0){
-                        couleur.g = (2/ymax)*moyenne_hauteur+1;
-                    }
-                    else if (moyenne_hauteur > 0 && moyenne_hauteur < ymax/2){
-                        couleur.g = (-2/ymax)*moyenne_hauteur+1;
-                    }
-                    else {couleur.g = 0;}
-
-                }
-
-                //Triangle face
-                Triangle face = Triangle(Origine, PointX1, PointZ1, couleur);
-
-                this->triFaces.push_back(face);
-            }
-        }
+void Maillage::initSurfaceColors() {
+    // Color of the height of every vertex, interpolated over the triangles around it
+    GridView grid = renderField.getView();
+    ColorizeRowKernel colorize = getColorizeKernels().colorizeRow[colorType ? COLORMAP_DIVERGING : COLORMAP_SEA];
+    for(int ligne = 0; ligne < nbPointsZ; ligne ++) {
+        colorize(grid.row(ligne), surface.couleursRow(ligne), nbPointsX);
     }
+    staleProducts &= ~MESH_SURFACE_COLORS;
 }
 
-void Maillage::update(double delta_t)
-{
-    std::vector<Point> mesPoints = basePoints;
+void Maillage::refresh() {
+    if(staleProducts & MESH_SURFACE_POSITIONS) {
+        initSurfacePositions();
+    }
+    if(staleProducts & MESH_SURFACE_COLORS) {
+        initSurfaceColors();
+    }
+    // Without spheres there is nothing to move : they stay stale
+    if((staleProducts & MESH_SPHERES) && !this->spheres.empty()) {
+        initSpheres();
+    }
+}
 
-    //Moving wave origin
-    for(int i = 0; i < waves.size(); i++) {
+// Number of lines given to a worker at once, small enough to balance the waves footprints
+const int DEFORM_BAND_SIZE = 16;
 
-        //Deforming basePoints with each wave
-        mesPoints = waves[i]->deformGrid(mesPoints);
-        waves[i]->updateWave(delta_t, nbPointsX, nbPointsZ);
+// Deforms a band of lines with every wave, starting from the base heights
+class DeformBandTask : public RowTask
+{
+public:
+    HeightField *field;
+    const HeightField *baseField; // NULL : the waves are added to 0
+    const WaveRegistry *registry; // NULL when its waves are in the batch
+    const std::vector<Wave*> *waves;
+    const WaveBatch *batch; // NULL when the waves are applied one after the other
+    const PlaneWaveTables *planeTables; // Plane waves of the batch
+    const PhasorField *phasors; // NULL when the waves are applied one after the other
+    void run(int ligneDebut, int ligneFin)
+    {
+        if(baseField != NULL) {
+            field->copyLinesFrom(*baseField, ligneDebut, ligneFin);
+        }
+        else {
+            field->fillLines(0.0f, ligneDebut, ligneFin);
+        }
+        field->clearDisplacements(ligneDebut, ligneFin);
+
+        GridView grid = field->getView();
+        if(batch != NULL && !batch->isEmpty()) {
+            FusedRowKernel kernel = getWaveKernels().fusedRow;
+            for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+                kernel(grid.row(ligne), 0, grid.nbPointsX, grid.x(0), grid.step, grid.z(ligne), *batch);
+            }
+        }
+        if(batch != NULL && !batch->gerstners.empty()) {
+            // Second pass over the row while it is still in the L1 cache, with the horizontal displacements
+            GerstnerRowKernel kernel = getWaveKernels().gerstnerRow;
+            for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+                kernel(grid.row(ligne), grid.rowX(ligne), grid.rowZ(ligne), 0, grid.nbPointsX, grid.x(0), grid.step,
+                       grid.z(ligne), batch->gerstners.data(), batch->gerstners.size());
+            }
+        }
+        if(batch != NULL && !batch->planes.empty()) {
+            getWaveKernels().planeWaveRows(grid.heights, grid.rowStride, ligneDebut, ligneFin, *planeTables);
+        }
+        if(phasors != NULL) {
+            phasors->deformRows(grid, ligneDebut, ligneFin);
+        }
+        if(registry != NULL) {
+            registry->forEachTable([&](const auto &table) {table.deformRows(grid, ligneDebut, ligneFin);});
+        }
+        for(int i = 0; i < int(waves->size()); i++) {
+            (*waves)[i]->deformRows(grid, ligneDebut, ligneFin);
+        }
     }
+};
+
+// Plane waves whose tables are built by a worker at once
+const int PLANE_TABLES_BAND_SIZE = 4;
 
-    this->setPointsToRender(mesPoints);
+// Fills the separable tables of a band of plane waves : the "lines" of the task are the waves
+class PlaneTablesTask : public RowTask
+{
+public:
+    PlaneWaveTables *tables;
+    const std::vector<PlaneWaveParams> *planes;
+    GridView grid;
+    void run(int debut, int fin)
+    {
+        tables->build(planes->data(), debut, fin, grid.x(0), grid.z(0), grid.step);
+    }
+};
 
+void Maillage::update(double delta_t)
+{
+    step(delta_t);
+    interpolate(1);
 }
 
-void Maillage::render()
+void Maillage::seek(double t)
 {
-    for(int i = 0; i < this->spheres.size(); i++) {
-        this->spheres[i].render();
-    }
-    for(int i = 0; i < this->triFaces.size(); i++) {
-        this->triFaces[i].render();
+    // The tables move in closed form : one update by the whole gap is exact
+    double delta_t = t - time;
+    registry.forEachTable([&](auto &table) {table.update(delta_t, nbPointsX, nbPointsZ);});
+    for(int i = 0; i < int(waves.size()); i++) {
+        waves[i]->seek(waves[i]->getTime() + delta_t, nbPointsX, nbPointsZ);
     }
+    time = t;
+    update(0);
 }
 
-void Maillage::addWave(Wave *myWave)
+void Maillage::interpolate(double alpha)
 {
-    waves.push_back(myWave);
+    interpolate(previousField, field, alpha);
 }
 
-
-//Wave::Wave(Point waveOrigin) {
-//    this->waveOrigin = waveOrigin;
-//}
-
-ConicWave::ConicWave(Point waveOrigin, GLfloat waveHeight, GLfloat waveRadius, Vector waveSpeed, Vector waveAcceleration) {
-    this->waveOrigin = waveOrigin;
-    this->waveHeight = waveHeight;
-    this->waveRadius = waveRadius;
-    this->waveSpeed = waveSpeed;
-    this->waveAcceleration = waveAcceleration;
+void Maillage::interpolate(const HeightField &previous, const HeightField &current, double alpha)
+{
+    renderField.interpolatePositions(previous, current, alpha);
+    invalidate(MESH_ALL_PRODUCTS);
 }
 
-void ConicWave::updateWave(double delta_t, int nbPointsX, int nbPointsZ) {
-    double coeffAmortissement = 0.9;
-
-    Point origin = getWaveOrigin();
-    origin.translate(getWaveSpeed().integral(delta_t));
-    if(origin.x < -(0.5*nbPointsX) || origin.x > 0.5*nbPointsX) {
-        waveSpeed.x = -waveSpeed.x;
-        this->waveHeight *= coeffAmortissement;
+void Maillage::step(double delta_t)
+{
+    previousField.copyPositionsFrom(field);
+
+    // Every band of lines is deformed by all the waves, in parallel
+    // Each line is written by a single band, in the waves order : the result does not depend on the threads
+    // With the wave equation, the waves only give the source term of the solver
+    DeformBandTask task;
+    if(simulationMode != SIMULATION_ANALYTIC) {
+        task.field = &sourceField;
+        task.baseField = NULL;
     }
-    if(origin.z < -(0.5*nbPointsZ) || origin.z > 0.5*nbPointsZ) {
-        waveSpeed.z = -waveSpeed.z;
-        this->waveHeight *= coeffAmortissement;
+    else {
+        task.field = &field;
+        task.baseField = &baseField;
     }
-    setWaveOrigin(origin);
-}
-
-std::vector<Point> ConicWave::deformGrid(std::vector<Point> basePoints) {
-        for(int j = 0; j < basePoints.size(); j++) {
-            Point origin = getWaveOrigin();
-            //Searching points in the radius
-            GLfloat distanceToOrigin = pow(pow(basePoints[j].x-origin.x,2) + pow(basePoints[j].z-origin.z,2),0.5);
-
-            if(distanceToOrigin <= getWaveRadius()) {
-                    basePoints[j].y += - pow(
-                                         (
-                                                pow(basePoints[j].x-origin.x,2)
-                                            +   pow(basePoints[j].z-origin.z,2)
-                                          )
-                        /   pow(getWaveRadius()/getWaveHeight(),2)
-                                         ,0.5) + getWaveHeight();
+    if(fusedEvaluation) {
+        // Vectors keep their capacity from one frame to the next : no allocation once warmed up
+        batch.clear();
+        unbatchedWaves.clear();
+        // Circular waves sharing a frequency are summed by the phasor field, the others go in the batch
+        phasors.update(registry.circulars, task.field->getView(), delta_t, *pool);
+        task.phasors = &phasors;
+        registry.forEachTable([&](const auto &table) {table.addToBatch(batch);});
+        for(int i = 0; i < int(waves.size()); i++) {
+            if(!waves[i]->addToBatch(batch)) {
+                unbatchedWaves.push_back(waves[i]);
             }
         }
+        task.registry = NULL;
+        task.batch = &batch;
+        task.waves = &unbatchedWaves;
+        task.planeTables = &planeTables;
+        if(!batch.planes.empty()) {
+            // (nbPointsX + nbPointsZ) cosines per plane wave, once per frame, instead of one per point
+            PlaneTablesTask tablesTask;
+            tablesTask.tables = &planeTables;
+            tablesTask.planes = &batch.planes;
+            tablesTask.grid = task.field->getView();
+            planeTables.resize(batch.planes.size(), nbPointsX, nbPointsZ);
+            pool->parallelRows(tablesTask, batch.planes.size(), PLANE_TABLES_BAND_SIZE);
+        }
+    }
+    else {
+        task.registry = &registry;
+        task.batch = NULL;
+        task.planeTables = NULL;
+        task.phasors = NULL;
+        if(phasors.getNbGroups() > 0) {
+            phasors.clear(registry.circulars);
+        }
+        task.waves = &waves;
+    }
+    pool->parallelRows(task, nbPointsZ, DEFORM_BAND_SIZE);
 
-        return basePoints;
-
-}
+    if(simulationMode == SIMULATION_WAVE_EQUATION) {
+        solver.advance(field, &sourceField, delta_t, *pool);
+    }
+    else if(simulationMode == SIMULATION_SHALLOW_WATER) {
+        shallowWater.advance(field, &sourceField, delta_t, *pool);
+    }
 
-CircularWave::CircularWave(Point waveOrigin, GLfloat waveHeight, GLfloat waveWidth, GLfloat waveRadius, GLfloat waveSpeed, GLfloat waveAcceleration) {
-    this->waveOrigin = waveOrigin;
-    this->waveWidth = waveWidth;
-    this->waveHeight = waveHeight;
-    this->waveRadius = waveRadius;
-    this->waveSpeed = waveSpeed;
-    this->waveAcceleration = waveAcceleration;
+    //Moving wave origin, once every band is deformed
+    time += delta_t;
+    registry.forEachTable([&](auto &table) {table.update(delta_t, nbPointsX, nbPointsZ);});
+    for(int i = 0; i < waves.size(); i++) {
+        waves[i]->updateWave(delta_t, nbPointsX, nbPointsZ);
+    }
+    // Waves too weak to deform the grid are not visited anymore
+    GridView grid = field.getView();
+    waves.erase(std::remove_if(waves.begin(), waves.end(), [&](Wave *wave) {return wave->isRetired(grid);}), waves.end());
+    registry.retireCirculars(grid);
 }
 
-void CircularWave::updateWave(double delta_t, int nbPointsX, int nbPointsZ) {
-        GLfloat radius = getWaveRadius();
-        radius += (getWaveSpeed()*delta_t);
-        setWaveRadius(radius);
+void Maillage::setSimulationMode(SimulationMode mode)
+{
+    if(mode != SIMULATION_ANALYTIC && sourceField.getNbPoints() != baseField.getNbPoints()) {
+        sourceField = HeightField(nbPointsX, nbPointsZ, baseField.getOriginX(), baseField.getOriginZ(), baseField.getStep());
+    }
+    if(mode == SIMULATION_SHALLOW_WATER) {
+        shallowWater.reset(baseField);
+    }
+    field.copyHeightsFrom(baseField);
+    field.resetMotion();
+    previousField.copyPositionsFrom(field);
+    simulationMode = mode;
 }
 
-std::vector<Point> CircularWave::deformGrid(std::vector<Point> basePoints) {
-
-        Point origin = getWaveOrigin();
-        double pi = 3.1415;
-        double coeffAmortissement = -0.05;
 
-        for(int j = 0; j < basePoints.size(); j++) {
-            //Searching points before and after the radius (+ and - width)
-            GLfloat distanceToOrigin = pow(pow(basePoints[j].x-origin.x,2) + pow(basePoints[j].z-origin.z,2),0.5);
+void Maillage::setBathymetry(const HeightField &bathymetry)
+{
+    baseField.copyHeightsFrom(bathymetry);
+    setSimulationMode(simulationMode);
+}
 
-            if(distanceToOrigin <= getWaveRadius()+getWaveWidth()/2) {
-                double dephasage = getWaveRadius()-distanceToOrigin;
 
-                basePoints[j].y += (getWaveHeight()*exp(coeffAmortissement*distanceToOrigin))*cos((pi/getWaveWidth())*(distanceToOrigin-getWaveRadius()));
-            }
-        }
+void Maillage::render()
+{
+    refresh();
+    for(int i = 0; i < this->spheres.size(); i++) {
+        this->spheres[i].render();
+    }
+    this->surface.render();
+}
 
-        return basePoints;
+void Maillage::addWave(Wave *myWave)
+{
+    waves.push_back(myWave);
 }
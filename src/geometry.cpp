@@ -2,70 +2,78 @@
 #include "geometry.h"
 
 
-void Point::translate(const Vector &v)
+template<class T>
+void BasicPoint<T>::translate(const BasicVector<T> &v)
 {
-    x += v.x;
-    y += v.y;
-    z += v.z;
+    this->x += v.x;
+    this->y += v.y;
+    this->z += v.z;
 }
 
 
-Vector::Vector(Point p1, Point p2)
+template<class T>
+BasicVector<T>::BasicVector(BasicPoint<T> p1, BasicPoint<T> p2)
 {
-    x = p2.x - p1.x;
-    y = p2.y - p1.y;
-    z = p2.z - p1.z;
+    this->x = p2.x - p1.x;
+    this->y = p2.y - p1.y;
+    this->z = p2.z - p1.z;
 }
 
 
-double Vector::norm()
+template<class T>
+T BasicVector<T>::norm()
 {
-    double norm;
+    T norm;
 
-    norm = sqrt(pow(x, 2) + pow(y, 2) + pow(z, 2));
+    norm = sqrt(this->x*this->x + this->y*this->y + this->z*this->z);
 
     return norm;
 }
 
 
-Vector Vector::integral(double delta_t)
+template<class T>
+BasicVector<T> BasicVector<T>::integral(T delta_t)
 {
-    Vector res;
+    BasicVector<T> res;
 
-    res.x = delta_t * x;
-    res.y = delta_t * y;
-    res.z = delta_t * z;
+    res.x = delta_t * this->x;
+    res.y = delta_t * this->y;
+    res.z = delta_t * this->z;
 
     return res;
 }
 
 
-void Vector::operator+=(const Vector &v)
+template<class T>
+void BasicVector<T>::operator+=(const BasicVector<T> &v)
 {
-    x += v.x;
-    y += v.y;
-    z += v.z;
+    this->x += v.x;
+    this->y += v.y;
+    this->z += v.z;
 }
 
 
-double distance(Point p1, Point p2)
+template<class T>
+T distance(BasicPoint<T> p1, BasicPoint<T> p2)
 {
-    Vector vect(p1, p2);
+    BasicVector<T> vect(p1, p2);
 
     return vect.norm();
 }
 
 
 // Overloaded standard operators
-std::ostream& operator<<(std::ostream& os, const Coordinates& coord)
+template<class T>
+std::ostream& operator<<(std::ostream& os, const BasicCoordinates<T>& coord)
 {
     os << '(' << coord.x << ", " << coord.y << ", " << coord.z << ')';
     return os;
 }
 
-Vector operator+(const Vector &v1, const Vector &v2)
+template<class T>
+BasicVector<T> operator+(const BasicVector<T> &v1, const BasicVector<T> &v2)
 {
-    Vector res = v1;
+    BasicVector<T> res = v1;
 
     res.x += v2.x;
     res.y += v2.y;
@@ -74,9 +82,10 @@ Vector operator+(const Vector &v1, const Vector &v2)
     return res;
 }
 
-Vector operator-(const Vector &v)
+template<class T>
+BasicVector<T> operator-(const BasicVector<T> &v)
 {
-    Vector res;
+    BasicVector<T> res;
 
     res.x = -v.x;
     res.y = -v.y;
@@ -85,18 +94,20 @@ Vector operator-(const Vector &v)
     return res;
 }
 
-Vector operator-(const Vector &v1, const Vector &v2)
+template<class T>
+BasicVector<T> operator-(const BasicVector<T> &v1, const BasicVector<T> &v2)
 {
-    Vector res = -v2;
+    BasicVector<T> res = -v2;
 
     res = res + v1;
 
     return res;
 }
 
-Vector operator*(const double &k, const Vector &v)
+template<class T>
+BasicVector<T> operator*(const typename BasicVector<T>::Scalar &k, const BasicVector<T> &v)
 {
-    Vector res = v;
+    BasicVector<T> res = v;
 
     res.x *= k;
     res.y *= k;
@@ -106,9 +117,10 @@ Vector operator*(const double &k, const Vector &v)
 }
 
 // Scalar product
-double operator*(const Vector &v1, const Vector &v2)
+template<class T>
+T operator*(const BasicVector<T> &v1, const BasicVector<T> &v2)
 {
-    double res;
+    T res;
 
     res = v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
 
@@ -116,9 +128,10 @@ double operator*(const Vector &v1, const Vector &v2)
 }
 
 // Vector product
-Vector operator^(const Vector &v1, const Vector &v2)
+template<class T>
+BasicVector<T> operator^(const BasicVector<T> &v1, const BasicVector<T> &v2)
 {
-    Vector res;
+    BasicVector<T> res;
 
     res.x = v1.y * v2.z - v1.z * v2.y;
     res.y = v1.z * v2.x - v1.x * v2.z;
@@ -126,3 +139,16 @@ Vector operator^(const Vector &v1, const Vector &v2)
 
     return res;
 }
+
+
+// The precision in use
+template class BasicPoint<double>;
+template class BasicVector<double>;
+template double distance(Point, Point);
+template std::ostream& operator<<(std::ostream&, const Coordinates&);
+template Vector operator+(const Vector&, const Vector&);
+template Vector operator-(const Vector&);
+template Vector operator-(const Vector&, const Vector&);
+template Vector operator*(const double&, const Vector&);
+template double operator*(const Vector&, const Vector&);
+template Vector operator^(const Vector&, const Vector&);
@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <SDL2/SDL_video.h>
+#include "glbuffers.h"
+
+
+// Loads the functions, with the suffix of the extension if any
+static bool loadGLBufferFunctions(GLBufferFunctions &gl, const char *suffixe)
+{
+    char nom[64];
+    snprintf(nom, sizeof(nom), "glGenBuffers%s", suffixe);
+    gl.genBuffers = (PFNGLGENBUFFERSPROC)SDL_GL_GetProcAddress(nom);
+    snprintf(nom, sizeof(nom), "glDeleteBuffers%s", suffixe);
+    gl.deleteBuffers = (PFNGLDELETEBUFFERSPROC)SDL_GL_GetProcAddress(nom);
+    snprintf(nom, sizeof(nom), "glBindBuffer%s", suffixe);
+    gl.bindBuffer = (PFNGLBINDBUFFERPROC)SDL_GL_GetProcAddress(nom);
+    snprintf(nom, sizeof(nom), "glBufferData%s", suffixe);
+    gl.bufferData = (PFNGLBUFFERDATAPROC)SDL_GL_GetProcAddress(nom);
+    snprintf(nom, sizeof(nom), "glBufferSubData%s", suffixe);
+    gl.bufferSubData = (PFNGLBUFFERSUBDATAPROC)SDL_GL_GetProcAddress(nom);
+    return gl.genBuffers != NULL && gl.deleteBuffers != NULL && gl.bindBuffer != NULL && gl.bufferData != NULL
+           && gl.bufferSubData != NULL;
+}
+
+
+const GLBufferFunctions* getGLBufferFunctions()
+{
+    static GLBufferFunctions gl;
+    static bool charge = false, disponible = false;
+    if(!charge) {
+        charge = true;
+        // The addresses may be returned for functions the context does not have : the version is checked first
+        int majeur = 0, mineur = 0;
+        const char *version = (const char*)glGetString(GL_VERSION);
+        if(version != NULL) {
+            sscanf(version, "%d.%d", &majeur, &mineur);
+        }
+        if(majeur > 1 || (majeur == 1 && mineur >= 5)) {
+            disponible = loadGLBufferFunctions(gl, "");
+        }
+        else if(SDL_GL_ExtensionSupported("GL_ARB_vertex_buffer_object")) {
+            disponible = loadGLBufferFunctions(gl, "ARB");
+        }
+    }
+    return disponible ? &gl : NULL;
+}
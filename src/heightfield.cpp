@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "heightfield.h"
+
+
+GridView::GridView(GLfloat *h, int nbX, int nbZ, int stride, double orgX, double orgZ, double st)
+{
+    heights = h;
+    displacementsX = displacementsZ = NULL;
+    nbPointsX = nbX;
+    nbPointsZ = nbZ;
+    rowStride = stride;
+    originX = orgX;
+    originZ = orgZ;
+    step = st;
+}
+
+
+// Tolerance on the bounds, so that points lying exactly on a wave border are kept
+const double BOUND_TOLERANCE = 1e-4;
+
+static void indicesBetween(double origin, double step, int nbPoints, double vMin, double vMax, int *debut, int *fin)
+{
+    if(!(vMin <= vMax)) { // Also rejects NaN bounds
+        *debut = *fin = 0;
+        return;
+    }
+    double premier = ceil((vMin - origin) / step - BOUND_TOLERANCE);
+    double dernier = floor((vMax - origin) / step + BOUND_TOLERANCE);
+    *debut = premier < 0 ? 0 : (premier > nbPoints ? nbPoints : int(premier));
+    *fin = dernier < 0 ? 0 : (dernier >= nbPoints ? nbPoints : int(dernier) + 1);
+}
+
+
+void GridView::columnsBetween(double xMin, double xMax, int *debut, int *fin) const
+{
+    indicesBetween(originX, step, nbPointsX, xMin, xMax, debut, fin);
+}
+
+
+void GridView::linesBetween(double zMin, double zMax, int *debut, int *fin) const
+{
+    indicesBetween(originZ, step, nbPointsZ, zMin, zMax, debut, fin);
+}
+
+
+GridRect GridView::discRect(double centreX, double centreZ, double rayon) const
+{
+    GridRect rect;
+    linesBetween(centreZ - rayon, centreZ + rayon, &rect.ligneDebut, &rect.ligneFin);
+    columnsBetween(centreX - rayon, centreX + rayon, &rect.colonneDebut, &rect.colonneFin);
+    return rect;
+}
+
+
+void GridView::discRowSpan(double centreX, double centreZ, double rayon, int ligne, int *debut, int *fin) const
+{
+    double dz = z(ligne) - centreZ;
+    double demiCorde = sqrt(std::max(0.0, rayon*rayon - dz*dz));
+    columnsBetween(centreX - demiCorde, centreX + demiCorde, debut, fin);
+}
+
+
+GridRect::GridRect(int lDebut, int lFin, int cDebut, int cFin)
+{
+    ligneDebut = lDebut;
+    ligneFin = lFin;
+    colonneDebut = cDebut;
+    colonneFin = cFin;
+}
+
+
+HeightField::HeightField(int nbPointsX, int nbPointsZ, double originX, double originZ, double step)
+{
+    this->nbPointsX = nbPointsX;
+    this->nbPointsZ = nbPointsZ;
+    this->originX = originX;
+    this->originZ = originZ;
+    this->step = step;
+    // Rounding the row length up to the padding
+    rowStride = (nbPointsX + HEIGHTFIELD_ROW_PADDING - 1) / HEIGHTFIELD_ROW_PADDING * HEIGHTFIELD_ROW_PADDING;
+
+    speedStorage = accelerationStorage = displacementXStorage = displacementZStorage = NULL;
+    speedPlane = accelerationPlane = displacementXPlane = displacementZPlane = NULL;
+    allocatePlane(&heightStorage, &heightPlane);
+}
+
+
+HeightField::HeightField(const HeightField &field)
+{
+    nbPointsX = field.nbPointsX;
+    nbPointsZ = field.nbPointsZ;
+    rowStride = field.rowStride;
+    originX = field.originX;
+    originZ = field.originZ;
+    step = field.step;
+
+    copyPlane(field.heightPlane, &heightStorage, &heightPlane);
+    copyPlane(field.speedPlane, &speedStorage, &speedPlane);
+    copyPlane(field.accelerationPlane, &accelerationStorage, &accelerationPlane);
+    copyPlane(field.displacementXPlane, &displacementXStorage, &displacementXPlane);
+    copyPlane(field.displacementZPlane, &displacementZStorage, &displacementZPlane);
+}
+
+
+HeightField& HeightField::operator=(const HeightField &field)
+{
+    if(this != &field) {
+        release();
+        nbPointsX = field.nbPointsX;
+        nbPointsZ = field.nbPointsZ;
+        rowStride = field.rowStride;
+        originX = field.originX;
+        originZ = field.originZ;
+        step = field.step;
+
+        copyPlane(field.heightPlane, &heightStorage, &heightPlane);
+        copyPlane(field.speedPlane, &speedStorage, &speedPlane);
+        copyPlane(field.accelerationPlane, &accelerationStorage, &accelerationPlane);
+        copyPlane(field.displacementXPlane, &displacementXStorage, &displacementXPlane);
+        copyPlane(field.displacementZPlane, &displacementZStorage, &displacementZPlane);
+    }
+    return *this;
+}
+
+
+HeightField::~HeightField()
+{
+    release();
+}
+
+
+void HeightField::allocatePlane(GLfloat **storage, GLfloat **plane)
+{
+    // Over-allocating to be able to shift the plane start on the alignment
+    *storage = new GLfloat[getPlaneSize() + HEIGHTFIELD_ROW_PADDING];
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(*storage);
+    address = (address + HEIGHTFIELD_ALIGNMENT - 1) & ~std::uintptr_t(HEIGHTFIELD_ALIGNMENT - 1);
+    *plane = reinterpret_cast<GLfloat*>(address);
+    // Padding included, so that vector kernels can read whole rows
+    std::fill(*plane, *plane + getPlaneSize(), 0.0f);
+}
+
+
+void HeightField::copyPlane(const GLfloat *source, GLfloat **storage, GLfloat **plane)
+{
+    if(source == NULL) {
+        *storage = NULL;
+        *plane = NULL;
+    }
+    else {
+        allocatePlane(storage, plane);
+        std::copy(source, source + getPlaneSize(), *plane);
+    }
+}
+
+
+void HeightField::release()
+{
+    delete[] heightStorage;
+    delete[] speedStorage;
+    delete[] accelerationStorage;
+    delete[] displacementXStorage;
+    delete[] displacementZStorage;
+    heightStorage = speedStorage = accelerationStorage = displacementXStorage = displacementZStorage = NULL;
+    heightPlane = speedPlane = accelerationPlane = displacementXPlane = displacementZPlane = NULL;
+}
+
+
+void HeightField::enableSpeeds()
+{
+    if(speedPlane == NULL) {
+        allocatePlane(&speedStorage, &speedPlane);
+    }
+}
+
+
+void HeightField::enableAccelerations()
+{
+    if(accelerationPlane == NULL) {
+        allocatePlane(&accelerationStorage, &accelerationPlane);
+    }
+}
+
+
+void HeightField::enableDisplacements()
+{
+    if(displacementXPlane == NULL) {
+        allocatePlane(&displacementXStorage, &displacementXPlane);
+        allocatePlane(&displacementZStorage, &displacementZPlane);
+    }
+}
+
+
+GridView HeightField::getView()
+{
+    GridView view(heightPlane, nbPointsX, nbPointsZ, rowStride, originX, originZ, step);
+    view.displacementsX = displacementXPlane;
+    view.displacementsZ = displacementZPlane;
+    return view;
+}
+
+
+Point HeightField::getPoint(int ligne, int colonne) const
+{
+    int i = index(ligne, colonne);
+    if(displacementXPlane != NULL) {
+        return Point(x(colonne) + displacementXPlane[i], heightPlane[i], z(ligne) + displacementZPlane[i]);
+    }
+    return Point(x(colonne), heightPlane[i], z(ligne));
+}
+
+
+void HeightField::copyHeightsFrom(const HeightField &field)
+{
+    std::copy(field.heightPlane, field.heightPlane + getPlaneSize(), heightPlane);
+}
+
+
+void HeightField::copyLinesFrom(const HeightField &field, int ligneDebut, int ligneFin)
+{
+    std::copy(field.heightPlane + ligneDebut*rowStride, field.heightPlane + ligneFin*rowStride,
+              heightPlane + ligneDebut*rowStride);
+}
+
+
+void HeightField::copyPositionsFrom(const HeightField &field)
+{
+    copyHeightsFrom(field);
+    if(displacementXPlane != NULL && field.displacementXPlane != NULL) {
+        std::copy(field.displacementXPlane, field.displacementXPlane + getPlaneSize(), displacementXPlane);
+        std::copy(field.displacementZPlane, field.displacementZPlane + getPlaneSize(), displacementZPlane);
+    }
+}
+
+
+static void interpolatePlane(GLfloat *plane, const GLfloat *previous, const GLfloat *current, GLfloat alpha, int size)
+{
+    for(int i = 0; i < size; i++) {
+        plane[i] = previous[i] + alpha*(current[i] - previous[i]);
+    }
+}
+
+
+void HeightField::interpolatePositions(const HeightField &previous, const HeightField &current, GLfloat alpha)
+{
+    interpolatePlane(heightPlane, previous.heightPlane, current.heightPlane, alpha, getPlaneSize());
+    if(displacementXPlane != NULL && previous.displacementXPlane != NULL && current.displacementXPlane != NULL) {
+        interpolatePlane(displacementXPlane, previous.displacementXPlane, current.displacementXPlane, alpha,
+                         getPlaneSize());
+        interpolatePlane(displacementZPlane, previous.displacementZPlane, current.displacementZPlane, alpha,
+                         getPlaneSize());
+    }
+}
+
+
+void HeightField::fill(GLfloat h)
+{
+    fillLines(h, 0, nbPointsZ);
+}
+
+
+void HeightField::fillLines(GLfloat h, int ligneDebut, int ligneFin)
+{
+    for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+        std::fill(heightPlane + ligne*rowStride, heightPlane + ligne*rowStride + nbPointsX, h);
+    }
+}
+
+
+void HeightField::clearDisplacements(int ligneDebut, int ligneFin)
+{
+    if(displacementXPlane != NULL) {
+        std::fill(displacementXPlane + ligneDebut*rowStride, displacementXPlane + ligneFin*rowStride, 0.0f);
+        std::fill(displacementZPlane + ligneDebut*rowStride, displacementZPlane + ligneFin*rowStride, 0.0f);
+    }
+}
+
+
+void HeightField::resetMotion()
+{
+    if(speedPlane != NULL) {
+        std::fill(speedPlane, speedPlane + getPlaneSize(), 0.0f);
+    }
+    if(accelerationPlane != NULL) {
+        std::fill(accelerationPlane, accelerationPlane + getPlaneSize(), 0.0f);
+    }
+}
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cmath>
+#include "phasorfield.h"
+
+
+// Lines of a band of the amplitude update
+const int PHASOR_BAND_SIZE = 16;
+
+
+// Adds the newly reached rings of the sources and subtracts the leaving ones, on a band of lines of every group
+class PhasorBandTask : public RowTask
+{
+public:
+    const std::vector<PhasorField::Group*> *groups;
+    GridView grid;
+    void run(int ligneDebut, int ligneFin)
+    {
+        for(int g = 0; g < int(groups->size()); g++) {
+            PhasorField::Group &group = *(*groups)[g];
+            for(int s = 0; s < int(group.sources.size()); s++) {
+                const PhasorField::Source &source = group.sources[s];
+                double rayonDebut = -1, rayonFin = source.reachAdded;
+                float sign = -1;
+                if(!source.leaving) {
+                    rayonDebut = source.reachAdded;
+                    rayonFin = source.reach;
+                    sign = 1;
+                }
+                if(rayonFin <= rayonDebut || rayonFin < 0) {
+                    continue;
+                }
+                GridRect rect = grid.discRect(source.originX, source.originZ, rayonFin);
+                if(rect.isEmpty()) {
+                    continue;
+                }
+                int fin = std::min(ligneFin, rect.ligneFin);
+                for(int ligne = std::max(ligneDebut, rect.ligneDebut); ligne < fin; ligne++) {
+                    PhasorField::accumulate(group, source, grid, ligne, rayonDebut, rayonFin, sign);
+                }
+            }
+        }
+    }
+};
+
+
+PhasorField::PhasorField()
+{
+    lastDelta = 0;
+}
+
+
+PhasorField::~PhasorField()
+{
+    for(int g = 0; g < int(groups.size()); g++) {
+        delete groups[g];
+    }
+}
+
+
+int PhasorField::getNbSources() const
+{
+    int nbSources = 0;
+    for(int g = 0; g < int(groups.size()); g++) {
+        nbSources += groups[g]->sources.size();
+    }
+    return nbSources;
+}
+
+
+void PhasorField::clear(WaveTable<CircularWaveColumns> &table)
+{
+    for(int g = 0; g < int(groups.size()); g++) {
+        delete groups[g];
+    }
+    groups.clear();
+    std::fill(groupOfHandle.begin(), groupOfHandle.end(), -1);
+    std::fill(table.inPhasorField.begin(), table.inPhasorField.end(), 0);
+}
+
+
+PhasorField::Source PhasorField::makeSource(const WaveTable<CircularWaveColumns> &table, int index, double theta) const
+{
+    CircularKernelParams params(table.originX[index], table.originZ[index], table.radius[index], table.width[index],
+                                table.height[index], table.epsilon[index]);
+    Source source;
+    source.handle = table.handleAt(index);
+    source.originX = table.originX[index];
+    source.originZ = table.originZ[index];
+    source.height = table.height[index];
+    source.width = table.width[index];
+    source.speed = table.speed[index];
+    source.epsilon = table.epsilon[index];
+    source.pulsation = params.pulsation;
+    source.amortissement = params.amortissement;
+    source.radius = table.radius[index];
+    source.phase = source.pulsation*source.radius - theta;
+    source.reachAdded = -1;
+    source.reach = params.reach;
+    source.leaving = false;
+    return source;
+}
+
+
+bool PhasorField::follows(const Source &source, const WaveTable<CircularWaveColumns> &table) const
+{
+    if(!table.contains(source.handle)) {
+        return false;
+    }
+    int index = table.indexOf(source.handle);
+    return table.originX[index] == source.originX && table.originZ[index] == source.originZ
+           && table.height[index] == source.height && table.width[index] == source.width
+           && table.speed[index] == source.speed && table.epsilon[index] == source.epsilon
+           && fabs(table.radius[index] - source.radius) <= PHASOR_RADIUS_TOLERANCE*source.width;
+}
+
+
+void PhasorField::addGroup(double omega)
+{
+    Group *group = new Group();
+    group->omega = omega;
+    group->theta = 0;
+    group->re = HeightField(grid.nbPointsX, grid.nbPointsZ, grid.originX, grid.originZ, grid.step);
+    group->im = HeightField(grid.nbPointsX, grid.nbPointsZ, grid.originX, grid.originZ, grid.step);
+    group->re.fill(0);
+    group->im.fill(0);
+    groups.push_back(group);
+}
+
+
+void PhasorField::update(WaveTable<CircularWaveColumns> &table, const GridView &grid, double delta_t, ThreadPool &pool)
+{
+    double pi = 3.14159265358979323846;
+
+    if(grid.nbPointsX != this->grid.nbPointsX || grid.nbPointsZ != this->grid.nbPointsZ
+       || grid.originX != this->grid.originX || grid.originZ != this->grid.originZ || grid.step != this->grid.step) {
+        clear(table);
+    }
+    this->grid = grid;
+    if(int(groupOfHandle.size()) < table.size()) {
+        groupOfHandle.resize(table.size(), -1);
+    }
+
+    // The table moved the rings since the last frame : so do the groups, the waves which did not follow leave
+    for(int g = 0; g < int(groups.size()); g++) {
+        Group &group = *groups[g];
+        group.theta += group.omega*lastDelta;
+        group.theta -= 2*pi*floor(group.theta / (2*pi));
+        for(int s = 0; s < int(group.sources.size()); s++) {
+            Source &source = group.sources[s];
+            source.radius += source.speed*lastDelta;
+            if(!follows(source, table)) {
+                source.leaving = true;
+                if(source.handle < int(groupOfHandle.size())) {
+                    groupOfHandle[source.handle] = -1;
+                }
+            }
+            else {
+                CircularKernelParams params(0, 0, table.radius[table.indexOf(source.handle)], source.width, source.height,
+                                            source.epsilon);
+                source.reach = params.reach;
+            }
+        }
+    }
+    lastDelta = delta_t;
+
+    // Waves out of any group join the one of their frequency, or a new one if enough of them share it
+    // Growing rings only : a shrinking one would have to be removed from the points it leaves
+    candidates.clear();
+    for(int i = 0; i < table.size(); i++) {
+        int handle = table.handleAt(i);
+        if(handle >= int(groupOfHandle.size())) {
+            groupOfHandle.resize(handle + 1, -1);
+        }
+        if(groupOfHandle[handle] < 0 && table.height[i] != 0 && table.speed[i] >= 0) {
+            CircularKernelParams params(0, 0, 0, table.width[i], 0);
+            candidates.push_back(std::make_pair((double)params.pulsation*table.speed[i], i));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for(int debut = 0; debut < int(candidates.size());) {
+        int fin = debut + 1;
+        while(fin < int(candidates.size()) && candidates[fin].first == candidates[debut].first) {
+            fin++;
+        }
+        int g = 0;
+        while(g < int(groups.size()) && groups[g]->omega != candidates[debut].first) {
+            g++;
+        }
+        if(g == int(groups.size()) && fin - debut >= PHASOR_MIN_SOURCES) {
+            addGroup(candidates[debut].first);
+        }
+        if(g < int(groups.size())) {
+            for(int c = debut; c < fin; c++) {
+                groups[g]->sources.push_back(makeSource(table, candidates[c].second, groups[g]->theta));
+            }
+        }
+        debut = fin;
+    }
+
+    PhasorBandTask task;
+    task.groups = &groups;
+    task.grid = grid;
+    pool.parallelRows(task, grid.nbPointsZ, PHASOR_BAND_SIZE);
+    commit(table);
+}
+
+
+void PhasorField::commit(WaveTable<CircularWaveColumns> &table)
+{
+    std::fill(groupOfHandle.begin(), groupOfHandle.end(), -1);
+    std::fill(table.inPhasorField.begin(), table.inPhasorField.end(), 0);
+
+    int nbGroups = 0;
+    for(int g = 0; g < int(groups.size()); g++) {
+        Group *group = groups[g];
+        int nbSources = 0;
+        for(int s = 0; s < int(group->sources.size()); s++) {
+            Source &source = group->sources[s];
+            if(!source.leaving) {
+                source.reachAdded = std::max(source.reachAdded, source.reach);
+                groupOfHandle[source.handle] = nbGroups;
+                table.inPhasorField[table.indexOf(source.handle)] = 1;
+                group->sources[nbSources++] = source;
+            }
+        }
+        group->sources.resize(nbSources);
+        if(nbSources > 0) {
+            groups[nbGroups++] = group;
+        }
+        else {
+            delete group;
+        }
+    }
+    groups.resize(nbGroups);
+}
+
+
+void PhasorField::accumulate(Group &group, const Source &source, const GridView &grid, int ligne, double rayonDebut,
+                             double rayonFin, float sign)
+{
+    // Chord of the outer disc, without the chord of the inner one
+    // The chord of a line out of the disc is not empty but its nearest column : the lines are checked first
+    double dz = grid.z(ligne) - source.originZ;
+    if(fabs(dz) > rayonFin) {
+        return;
+    }
+    int debut, fin, interieurDebut = 0, interieurFin = 0;
+    grid.discRowSpan(source.originX, source.originZ, rayonFin, ligne, &debut, &fin);
+    if(fabs(dz) <= rayonDebut) {
+        grid.discRowSpan(source.originX, source.originZ, rayonDebut, ligne, &interieurDebut, &interieurFin);
+    }
+    if(interieurDebut >= interieurFin) {
+        interieurDebut = interieurFin = fin;
+    }
+
+    GLfloat *re = group.re.heights() + group.re.index(ligne, 0);
+    GLfloat *im = group.im.heights() + group.im.index(ligne, 0);
+    for(int colonne = debut; colonne < fin; colonne++) {
+        if(colonne == interieurDebut) {
+            colonne = interieurFin;
+            if(colonne >= fin) {
+                break;
+            }
+        }
+        double dx = grid.x(colonne) - source.originX;
+        double distance = sqrt(dx*dx + dz*dz);
+        double amplitude = sign*source.height*exp(source.amortissement*distance);
+        double angle = source.pulsation*distance - source.phase;
+        re[colonne] += amplitude*cos(angle);
+        im[colonne] += amplitude*sin(angle);
+    }
+}
+
+
+void PhasorField::deformRows(const GridView &grid, int ligneDebut, int ligneFin) const
+{
+    PhasorRowKernel kernel = getWaveKernels().phasorRow;
+
+    for(int g = 0; g < int(groups.size()); g++) {
+        const Group &group = *groups[g];
+        float cosTheta = cos(group.theta), sinTheta = sin(group.theta);
+        for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+            kernel(grid.row(ligne), group.re.heights() + group.re.index(ligne, 0),
+                   group.im.heights() + group.im.index(ligne, 0), grid.nbPointsX, cosTheta, sinTheta);
+        }
+    }
+}
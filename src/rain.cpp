@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cmath>
+#include "rain.h"
+
+
+// Widest vector of the kernels, in floats : the tiles are evaluated by whole vectors
+const int RAIN_SPAN_GRANULE = 16;
+
+
+// First column at or after v, and column after the last one at or before v, within [debut, fin]
+// Without the libm ceil and floor calls of the baseline instruction set
+static inline int colonneApres(double v, int debut, int fin)
+{
+    if(!(v > debut)) {
+        return debut;
+    }
+    if(v >= fin) {
+        return fin;
+    }
+    int colonne = int(v);
+    return colonne < v ? colonne + 1 : colonne;
+}
+
+static inline int colonneFinAvant(double v, int debut, int fin)
+{
+    if(!(v >= debut)) {
+        return debut;
+    }
+    return v >= fin ? fin : int(v) + 1;
+}
+
+
+RainEmitter::RainEmitter(const GridView &grid, int capacity, GLfloat rate, GLfloat dropHeight, GLfloat dropWidth,
+                         GLfloat dropSpeed, GLfloat dropLifetime, unsigned int seed)
+    : generateur(seed)
+{
+    this->grid = grid;
+    this->grid.heights = NULL;
+    this->grid.displacementsX = this->grid.displacementsZ = NULL;
+    this->capacity = capacity;
+    this->rate = rate;
+    this->dropHeight = dropHeight;
+    this->dropWidth = dropWidth;
+    this->dropSpeed = dropSpeed;
+    this->dropLifetime = dropLifetime;
+    epsilon = CIRCULAR_WAVE_EPSILON;
+    pendingDrops = 0;
+    nbLost = 0;
+
+    nbDrops = 0;
+    originX.resize(capacity);
+    originZ.resize(capacity);
+    height.resize(capacity);
+    radius.resize(capacity);
+    params.resize(capacity);
+    inner.resize(capacity);
+    centreColonne.resize(capacity);
+    reachColonnes.resize(capacity);
+    innerColonnes.resize(capacity);
+
+    nbTilesX = (grid.nbPointsX + RAIN_TILE_SIZE - 1) / RAIN_TILE_SIZE;
+    nbTilesZ = (grid.nbPointsZ + RAIN_TILE_SIZE - 1) / RAIN_TILE_SIZE;
+    tileDebut.assign(nbTilesX*nbTilesZ + 1, 0);
+    tileCursor.resize(nbTilesX*nbTilesZ);
+}
+
+
+void RainEmitter::spawn()
+{
+    if(nbDrops == capacity) {
+        nbLost++;
+        return;
+    }
+    std::uniform_real_distribution<double> x(grid.x(0), grid.x(grid.nbPointsX - 1));
+    std::uniform_real_distribution<double> z(grid.z(0), grid.z(grid.nbPointsZ - 1));
+    std::uniform_real_distribution<double> h(0.5*dropHeight, dropHeight);
+    originX[nbDrops] = x(generateur);
+    originZ[nbDrops] = z(generateur);
+    height[nbDrops] = h(generateur);
+    radius[nbDrops] = 0;
+    nbDrops++;
+}
+
+
+void RainEmitter::retire(int drop)
+{
+    nbDrops--;
+    originX[drop] = originX[nbDrops];
+    originZ[drop] = originZ[nbDrops];
+    height[drop] = height[nbDrops];
+    radius[drop] = radius[nbDrops];
+}
+
+
+void RainEmitter::updateWave(double delta_t, int, int)
+{
+    time += delta_t;
+    // Exponential fading : the drop is retired after dropLifetime * ln(height / epsilon)
+    GLfloat decay = exp(-delta_t / dropLifetime);
+    for(int i = 0; i < nbDrops;) {
+        radius[i] += dropSpeed*delta_t;
+        height[i] *= decay;
+        if(fabs(height[i]) < epsilon) {
+            // The last drop takes the slot and is moved in turn
+            retire(i);
+        }
+        else {
+            i++;
+        }
+    }
+
+    pendingDrops += rate*delta_t;
+    while(pendingDrops >= 1) {
+        spawn();
+        pendingDrops -= 1;
+    }
+
+    binDrops();
+}
+
+
+template<class F>
+void RainEmitter::forEachTile(int drop, F f) const
+{
+    const CircularKernelParams &p = params[drop];
+    int colonneDebut, colonneFin, ligneDebut, ligneFin;
+    grid.columnsBetween(p.originX - p.reach, p.originX + p.reach, &colonneDebut, &colonneFin);
+    grid.linesBetween(p.originZ - p.reach, p.originZ + p.reach, &ligneDebut, &ligneFin);
+    if(colonneDebut >= colonneFin || ligneDebut >= ligneFin) {
+        return;
+    }
+
+    double interieur2 = inner[drop] > 0 ? inner[drop]*inner[drop] : -1;
+    for(int tz = ligneDebut / RAIN_TILE_SIZE; tz <= (ligneFin - 1) / RAIN_TILE_SIZE; tz++) {
+        double zMin = grid.z(tz*RAIN_TILE_SIZE);
+        double zMax = grid.z(std::min((tz + 1)*RAIN_TILE_SIZE, grid.nbPointsZ) - 1);
+        double prochesZ = std::max(0.0, std::max(zMin - p.originZ, p.originZ - zMax));
+        double loinZ = std::max(p.originZ - zMin, zMax - p.originZ);
+        for(int tx = colonneDebut / RAIN_TILE_SIZE; tx <= (colonneFin - 1) / RAIN_TILE_SIZE; tx++) {
+            double xMin = grid.x(tx*RAIN_TILE_SIZE);
+            double xMax = grid.x(std::min((tx + 1)*RAIN_TILE_SIZE, grid.nbPointsX) - 1);
+            double prochesX = std::max(0.0, std::max(xMin - p.originX, p.originX - xMax));
+            double loinX = std::max(p.originX - xMin, xMax - p.originX);
+            // Tile out of the outer disc, or within the inner one
+            if(prochesX*prochesX + prochesZ*prochesZ > p.reach*p.reach || loinX*loinX + loinZ*loinZ < interieur2) {
+                continue;
+            }
+            f(tz*nbTilesX + tx);
+        }
+    }
+}
+
+
+void RainEmitter::binDrops()
+{
+    for(int i = 0; i < nbDrops; i++) {
+        params[i] = CircularKernelParams(originX[i], originZ[i], radius[i], dropWidth, height[i], epsilon);
+        inner[i] = radius[i] - RAIN_RING_TRAIL*dropWidth;
+        centreColonne[i] = (originX[i] - grid.originX) / grid.step;
+        reachColonnes[i] = params[i].reach / grid.step;
+        innerColonnes[i] = inner[i] / grid.step;
+    }
+
+    // Counting sort of the (tile, drop) pairs on the tile
+    std::fill(tileDebut.begin(), tileDebut.end(), 0);
+    for(int i = 0; i < nbDrops; i++) {
+        forEachTile(i, [&](int tile) {tileDebut[tile + 1]++;});
+    }
+    for(int t = 0; t < nbTilesX*nbTilesZ; t++) {
+        tileDebut[t + 1] += tileDebut[t];
+        tileCursor[t] = tileDebut[t];
+    }
+    tileDrops.resize(tileDebut.back());
+    for(int i = 0; i < nbDrops; i++) {
+        forEachTile(i, [&](int tile) {tileDrops[tileCursor[tile]++] = i;});
+    }
+}
+
+
+GridRect RainEmitter::getInfluenceRect(const GridView &grid)
+{
+    if(nbDrops == 0) {
+        return GridRect();
+    }
+    return Wave::getInfluenceRect(grid);
+}
+
+
+void RainEmitter::deformRows(const GridView &grid, int ligneDebut, int ligneFin)
+{
+    if(nbDrops == 0) {
+        return;
+    }
+    ligneFin = std::min(ligneFin, nbTilesZ*RAIN_TILE_SIZE);
+    for(int tz = ligneDebut / RAIN_TILE_SIZE; tz*RAIN_TILE_SIZE < ligneFin; tz++) {
+        int debut = std::max(ligneDebut, tz*RAIN_TILE_SIZE);
+        int fin = std::min(ligneFin, (tz + 1)*RAIN_TILE_SIZE);
+        for(int tx = 0; tx < nbTilesX; tx++) {
+            deformTile(grid, tz*nbTilesX + tx, debut, fin, tx*RAIN_TILE_SIZE,
+                       std::min(grid.nbPointsX, (tx + 1)*RAIN_TILE_SIZE));
+        }
+    }
+}
+
+
+void RainEmitter::deformRow(const GridView &grid, int ligne, int debut, int fin)
+{
+    int tz = ligne / RAIN_TILE_SIZE;
+    if(tz >= nbTilesZ) {
+        return;
+    }
+    int txFin = std::min(nbTilesX, (fin - 1) / RAIN_TILE_SIZE + 1);
+    for(int tx = debut / RAIN_TILE_SIZE; tx < txFin; tx++) {
+        deformTile(grid, tz*nbTilesX + tx, ligne, ligne + 1, std::max(debut, tx*RAIN_TILE_SIZE),
+                   std::min(fin, (tx + 1)*RAIN_TILE_SIZE));
+    }
+}
+
+
+void RainEmitter::deformTile(const GridView &grid, int tile, int ligneDebut, int ligneFin, int colonneDebut,
+                             int colonneFin)
+{
+    CircularRowKernel kernel = getWaveKernels().circularRow;
+    int tileX = tile % nbTilesX * RAIN_TILE_SIZE;
+    alignas(HEIGHTFIELD_ALIGNMENT) GLfloat tuile[RAIN_TILE_SIZE]; // A drop on the line of a tile
+
+    for(int k = tileDebut[tile]; k < tileDebut[tile + 1]; k++) {
+        int drop = tileDrops[k];
+        const CircularKernelParams &p = params[drop];
+        int debut, fin;
+        grid.linesBetween(p.originZ - p.reach, p.originZ + p.reach, &debut, &fin);
+        debut = std::max(debut, ligneDebut);
+        fin = std::min(fin, ligneFin);
+
+        for(int ligne = debut; ligne < fin; ligne++) {
+            // Chord of the ring, in columns : outer chord without the inner one
+            double dz = (grid.z(ligne) - p.originZ) / grid.step;
+            double demiCorde = sqrt(std::max(0.0, reachColonnes[drop]*reachColonnes[drop] - dz*dz));
+            int exterieurDebut = colonneApres(centreColonne[drop] - demiCorde, colonneDebut, colonneFin);
+            int exterieurFin = colonneFinAvant(centreColonne[drop] + demiCorde, colonneDebut, colonneFin);
+            if(exterieurDebut >= exterieurFin) {
+                continue;
+            }
+            int interieurDebut = exterieurFin, interieurFin = exterieurFin;
+            if(fabs(dz) < innerColonnes[drop]) {
+                demiCorde = sqrt(innerColonnes[drop]*innerColonnes[drop] - dz*dz);
+                interieurDebut = colonneApres(centreColonne[drop] - demiCorde, exterieurDebut, exterieurFin);
+                interieurFin = colonneFinAvant(centreColonne[drop] + demiCorde, exterieurDebut, exterieurFin);
+            }
+
+            // The chords are short : evaluated by whole vectors on the line of the tile, rather than by the scalar
+            // tail of the kernel
+            int premier = (exterieurDebut - tileX) / RAIN_SPAN_GRANULE * RAIN_SPAN_GRANULE;
+            int dernier = (exterieurFin - tileX + RAIN_SPAN_GRANULE - 1) / RAIN_SPAN_GRANULE * RAIN_SPAN_GRANULE;
+            std::fill(tuile + premier, tuile + dernier, 0.0f);
+            kernel(tuile, premier, dernier, grid.x(tileX), grid.step, grid.z(ligne), p);
+
+            GLfloat *hauteurs = grid.row(ligne);
+            for(int colonne = exterieurDebut; colonne < std::min(exterieurFin, interieurDebut); colonne++) {
+                hauteurs[colonne] += tuile[colonne - tileX];
+            }
+            for(int colonne = std::max(exterieurDebut, interieurFin); colonne < exterieurFin; colonne++) {
+                hauteurs[colonne] += tuile[colonne - tileX];
+            }
+        }
+    }
+}
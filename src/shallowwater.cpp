@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cmath>
+#include "shallowwater.h"
+#include "wavekernels.h"
+
+// Lines and columns of a tile : the fluxes of a tile take about 12 kB, they stay in the L1 cache
+const int SHALLOW_WATER_TILE_LINES = 16;
+const int SHALLOW_WATER_TILE_COLUMNS = 256;
+// A very long frame is not fully simulated rather than spending more than this many time steps on it
+const int MAX_SHALLOW_WATER_STEPS = 32;
+
+
+// Faces of one line of a tile
+class TileFluxes
+{
+public:
+    GLfloat masse[SHALLOW_WATER_TILE_COLUMNS + 1];
+    GLfloat normalGauche[SHALLOW_WATER_TILE_COLUMNS + 1];
+    GLfloat normalDroite[SHALLOW_WATER_TILE_COLUMNS + 1];
+    GLfloat tangente[SHALLOW_WATER_TILE_COLUMNS + 1];
+    ShallowWaterFluxes getFluxes() {return ShallowWaterFluxes{masse, normalGauche, normalDroite, tangente};}
+};
+
+
+static ShallowWaterRow shallowWaterRow(const HeightField &depth, const HeightField &momentumX,
+                                       const HeightField &momentumZ, const HeightField &bed, int ligne)
+{
+    int i = depth.index(ligne, 0);
+    return ShallowWaterRow{depth.heights() + i, momentumX.heights() + i, momentumZ.heights() + i, bed.heights() + i};
+}
+
+
+// One time step on the tiles of a band of lines, from the current state into the next one
+// The face between two lines of the tile is computed once, as the bottom of the first and the top of the second
+class ShallowWaterTileTask : public RowTask
+{
+public:
+    const HeightField *depth, *momentumX, *momentumZ, *bed;
+    HeightField *nextDepth, *nextMomentumX, *nextMomentumZ;
+    ShallowWaterParams params;
+    float *vitessesMax;
+    void run(int ligneDebut, int ligneFin)
+    {
+        const WaveKernels &kernels = getWaveKernels();
+        int nbLignes = depth->getNbPointsZ();
+        int nbPoints = depth->getNbPointsX();
+        TileFluxes x, flux1, flux2;
+        ShallowWaterFluxes fluxX = x.getFluxes();
+        float vitesseMax = 0;
+
+        for(int debut = 0; debut < nbPoints; debut += SHALLOW_WATER_TILE_COLUMNS) {
+            int fin = std::min(debut + SHALLOW_WATER_TILE_COLUMNS, nbPoints);
+            ShallowWaterFluxes haut = flux1.getFluxes(), bas = flux2.getFluxes();
+
+            // Top of the tile, a wall on the first line of the grid
+            ShallowWaterRow ligneHaut = shallowWaterRow(*depth, *momentumX, *momentumZ, *bed, std::max(ligneDebut-1, 0));
+            ShallowWaterRow ligne = shallowWaterRow(*depth, *momentumX, *momentumZ, *bed, ligneDebut);
+            kernels.shallowWaterFluxZ(ligneHaut, ligne, ligneDebut > 0 ? 1 : -1, 1, debut, fin, params, haut);
+
+            for(int l = ligneDebut; l < ligneFin; l++) {
+                ShallowWaterRow ligneBas = shallowWaterRow(*depth, *momentumX, *momentumZ, *bed, std::min(l+1, nbLignes-1));
+                kernels.shallowWaterFluxX(ligne, debut, fin, nbPoints, params, fluxX);
+                kernels.shallowWaterFluxZ(ligne, ligneBas, 1, l+1 < nbLignes ? 1 : -1, debut, fin, params, bas);
+
+                int i = nextDepth->index(l, 0);
+                float vitesse = kernels.shallowWaterUpdate(ligne, nextDepth->heights() + i, nextMomentumX->heights() + i,
+                                                           nextMomentumZ->heights() + i, fluxX, haut, bas, debut, fin, params);
+                vitesseMax = std::max(vitesseMax, vitesse);
+
+                std::swap(haut, bas);
+                ligne = ligneBas;
+            }
+        }
+
+        vitessesMax[ligneDebut / SHALLOW_WATER_TILE_LINES] = vitesseMax;
+    }
+};
+
+
+// Adds the change of the sources to the wet cells
+class ShallowWaterForcingTask : public RowTask
+{
+public:
+    HeightField *depth;
+    HeightField *previousSources;
+    const HeightField *sources;
+    float gain;
+    float dry;
+    void run(int ligneDebut, int ligneFin)
+    {
+        for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+            GLfloat *h = depth->heights() + depth->index(ligne, 0);
+            GLfloat *avant = previousSources->heights() + depth->index(ligne, 0);
+            const GLfloat *source = sources->heights() + depth->index(ligne, 0);
+            for(int colonne = 0; colonne < depth->getNbPointsX(); colonne++) {
+                if(h[colonne] > dry) {
+                    h[colonne] = std::max(0.0f, h[colonne] + gain*(source[colonne] - avant[colonne]));
+                }
+                avant[colonne] = source[colonne];
+            }
+        }
+    }
+};
+
+
+// Water surface, the bed itself on dry cells
+class ShallowWaterSurfaceTask : public RowTask
+{
+public:
+    HeightField *field;
+    const HeightField *depth, *bed;
+    void run(int ligneDebut, int ligneFin)
+    {
+        for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+            int i = field->index(ligne, 0);
+            for(int colonne = 0; colonne < field->getNbPointsX(); colonne++) {
+                field->heights()[i + colonne] = bed->heights()[i + colonne] + depth->heights()[i + colonne];
+            }
+        }
+    }
+};
+
+
+ShallowWaterSolver::ShallowWaterSolver(double gravity, double waterLevel, double sourceGain)
+{
+    this->gravity = gravity;
+    this->waterLevel = waterLevel;
+    this->sourceGain = sourceGain;
+    // Two dimensional Rusanov scheme : the depths stay positive below 0.5
+    cfl = 0.4;
+    dry = 1e-3;
+    actuel = 0;
+    vitesseMax = 0;
+}
+
+
+void ShallowWaterSolver::reset(const HeightField &bathymetry)
+{
+    int nbX = bathymetry.getNbPointsX(), nbZ = bathymetry.getNbPointsZ();
+    bed = bathymetry;
+    for(int i = 0; i < 2; i++) {
+        depth[i] = HeightField(nbX, nbZ, bathymetry.getOriginX(), bathymetry.getOriginZ(), bathymetry.getStep());
+        momentumX[i] = depth[i];
+        momentumZ[i] = depth[i];
+    }
+    previousSources = depth[0];
+    actuel = 0;
+
+    double profondeurMax = 0;
+    for(int ligne = 0; ligne < nbZ; ligne++) {
+        for(int colonne = 0; colonne < nbX; colonne++) {
+            int i = bed.index(ligne, colonne);
+            double h = std::max(0.0, waterLevel - bed.heights()[i]);
+            depth[0].heights()[i] = h;
+            profondeurMax = std::max(profondeurMax, h);
+        }
+    }
+    vitesseMax = sqrt(gravity*profondeurMax);
+    vitessesMax.assign((nbZ + SHALLOW_WATER_TILE_LINES - 1) / SHALLOW_WATER_TILE_LINES, 0.0f);
+}
+
+
+double ShallowWaterSolver::getMaxTimeStep() const
+{
+    // An empty basin has no speed limit, sqrt(g*dry) keeps the step finite
+    return cfl * bed.getStep() / std::max(vitesseMax, sqrt(gravity*dry));
+}
+
+
+void ShallowWaterSolver::advance(HeightField &field, const HeightField *sources, double delta_t, ThreadPool &pool)
+{
+    int nbLignes = bed.getNbPointsZ();
+    if(nbLignes == 0) {
+        return;
+    }
+
+    if(sources != NULL) {
+        ShallowWaterForcingTask forcing;
+        forcing.depth = &depth[actuel];
+        forcing.previousSources = &previousSources;
+        forcing.sources = sources;
+        forcing.gain = sourceGain;
+        forcing.dry = dry;
+        pool.parallelRows(forcing, nbLignes, SHALLOW_WATER_TILE_LINES);
+    }
+
+    ShallowWaterTileTask task;
+    task.bed = &bed;
+    task.params.gravity = gravity;
+    task.params.dry = dry;
+    task.vitessesMax = &vitessesMax[0];
+
+    // Time steps follow the fastest wave : the last one is shortened to end exactly at delta_t
+    double t = 0;
+    for(int pas = 0; pas < MAX_SHALLOW_WATER_STEPS && t < delta_t; pas++) {
+        double dt = std::min(getMaxTimeStep(), delta_t - t);
+        task.params.dtSurDx = dt / bed.getStep();
+        task.depth = &depth[actuel];
+        task.momentumX = &momentumX[actuel];
+        task.momentumZ = &momentumZ[actuel];
+        task.nextDepth = &depth[1 - actuel];
+        task.nextMomentumX = &momentumX[1 - actuel];
+        task.nextMomentumZ = &momentumZ[1 - actuel];
+        pool.parallelRows(task, nbLignes, SHALLOW_WATER_TILE_LINES);
+
+        actuel = 1 - actuel;
+        vitesseMax = *std::max_element(vitessesMax.begin(), vitessesMax.end());
+        t += dt;
+    }
+
+    ShallowWaterSurfaceTask surface;
+    surface.field = &field;
+    surface.depth = &depth[actuel];
+    surface.bed = &bed;
+    pool.parallelRows(surface, nbLignes, SHALLOW_WATER_TILE_LINES);
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <SDL2/SDL_timer.h>
+#include "simulationthread.h"
+
+
+CommandQueue::CommandQueue(int capacity) : slots(capacity + 1)
+{
+    SDL_AtomicSet(&head, 0);
+    SDL_AtomicSet(&tail, 0);
+}
+
+
+bool CommandQueue::push(const std::function<void()> &command)
+{
+    int fin = SDL_AtomicGet(&tail);
+    int suivant = (fin + 1) % slots.size();
+    if(suivant == SDL_AtomicGet(&head)) {
+        return false;
+    }
+    // The head was read before the slot is written : the consumer is done with it
+    SDL_MemoryBarrierAcquire();
+    slots[fin] = command;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&tail, suivant);
+    return true;
+}
+
+
+int CommandQueue::runAll()
+{
+    int debut = SDL_AtomicGet(&head);
+    int fin = SDL_AtomicGet(&tail);
+    SDL_MemoryBarrierAcquire();
+    int nbCommands = 0;
+    while(debut != fin) {
+        slots[debut]();
+        slots[debut] = nullptr;
+        debut = (debut + 1) % slots.size();
+        // The slot is given back once its command is released
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&head, debut);
+        nbCommands++;
+    }
+    return nbCommands;
+}
+
+
+SimulationThread::SimulationThread(Maillage &mesh, double stepDuration, int maxSteps)
+    : timestep(stepDuration, maxSteps)
+{
+    this->mesh = &mesh;
+    time = 0;
+
+    SimulationFrame frame;
+    frame.previous = mesh.getPreviousHeightField();
+    frame.current = mesh.getHeightField();
+    frames.fill(frame);
+
+    SDL_AtomicSet(&stopping, 0);
+    startCounter = SDL_GetPerformanceCounter();
+    thread = SDL_CreateThread(threadMain, "Simulation", this);
+}
+
+
+SimulationThread::~SimulationThread()
+{
+    SDL_AtomicSet(&stopping, 1);
+    SDL_WaitThread(thread, NULL);
+}
+
+
+int SimulationThread::threadMain(void *data)
+{
+    static_cast<SimulationThread*>(data)->run();
+    return 0;
+}
+
+
+void SimulationThread::run()
+{
+    Uint64 previousCounter = startCounter;
+    while(!SDL_AtomicGet(&stopping)) {
+        commands.runAll();
+
+        Uint64 counter = SDL_GetPerformanceCounter();
+        int nbSteps = timestep.advance(double(counter - previousCounter) / SDL_GetPerformanceFrequency());
+        previousCounter = counter;
+        for(int step = 0; step < nbSteps; step++) {
+            mesh->step(timestep.getStepDuration());
+            time += timestep.getStepDuration();
+        }
+
+        if(nbSteps > 0) {
+            SimulationFrame &frame = frames.getBack();
+            frame.previous.copyPositionsFrom(mesh->getPreviousHeightField());
+            frame.current.copyPositionsFrom(mesh->getHeightField());
+            frame.time = time;
+            frame.droppedTime = timestep.getDroppedTime();
+            frames.publish();
+        }
+
+        // Until the next step is due
+        SDL_Delay(Uint32(1000*(1 - timestep.getAlpha())*timestep.getStepDuration()));
+    }
+}
+
+
+double SimulationThread::getAlpha(const SimulationFrame &frame) const
+{
+    double elapsed = double(SDL_GetPerformanceCounter() - startCounter) / SDL_GetPerformanceFrequency();
+    double alpha = (elapsed - frame.droppedTime - frame.time) / timestep.getStepDuration();
+    return std::min(std::max(alpha, 0.0), 1.0);
+}
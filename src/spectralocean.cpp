@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "spectralocean.h"
+
+const double OCEAN_GRAVITY = 9.81;
+
+
+static int nextPowerOfTwo(int n)
+{
+    int p = 1;
+    while(p < n) {
+        p *= 2;
+    }
+    return p;
+}
+
+
+// Advances the spectrum of a band of wave vector rows and writes it into the FFT input
+class OceanSpectrumTask : public RowTask
+{
+public:
+    const GLfloat *reH0, *imH0, *reH0Conj, *imH0Conj, *omega;
+    GLfloat *phase;
+    Fft2D *fft;
+    int resolution;
+    float dt;
+    void run(int ligneDebut, int ligneFin)
+    {
+        OceanSpectrumKernel kernel = getWaveKernels().oceanSpectrumRow;
+        for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+            int i = ligne*resolution;
+            OceanSpectrumRow row = {reH0 + i, imH0 + i, reH0Conj + i, imH0Conj + i, omega + i, phase + i,
+                                    fft->real() + ligne*fft->getRowStride(), fft->imag() + ligne*fft->getRowStride()};
+            kernel(row, resolution, dt);
+        }
+    }
+};
+
+
+SpectralOceanWave::SpectralOceanWave(Point waveOrigin, int resolution, double patchSize, double windSpeed,
+                                     double windDirection, GLfloat significantHeight, ThreadPool &pool,
+                                     OceanSpectrum spectrum, unsigned int seed)
+    : fft(nextPowerOfTwo(resolution))
+{
+    this->waveOrigin = waveOrigin;
+    this->resolution = nextPowerOfTwo(resolution);
+    this->patchSize = patchSize;
+    this->significantHeight = significantHeight;
+    this->pool = &pool;
+
+    initSpectrum(windSpeed, windDirection, spectrum, seed);
+    synthesize(0);
+}
+
+
+void SpectralOceanWave::initSpectrum(double windSpeed, double windDirection, OceanSpectrum spectrum, unsigned int seed)
+{
+    const double pi = 3.14159265358979323846;
+    int n = resolution;
+    double dk = 2*pi / patchSize;
+    double ventX = cos(windDirection), ventZ = sin(windDirection);
+    // Largest wave of the Phillips spectrum, and the waves shorter than a sample are removed
+    double plusGrande = windSpeed*windSpeed / OCEAN_GRAVITY;
+    double plusPetite = patchSize / n;
+    // Peak of a fully developed JONSWAP sea
+    double omegaPic = 0.855 * OCEAN_GRAVITY / windSpeed;
+
+    std::mt19937 generateur(seed);
+    std::normal_distribution<double> gauss(0.0, 1.0);
+
+    reH0.assign(n*n, 0.0f);
+    imH0.assign(n*n, 0.0f);
+    omega.assign(n*n, 0.0f);
+    phase.assign(n*n, 0.0f);
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            double kx = dk * (i < n/2 ? i : i - n);
+            double kz = dk * (j < n/2 ? j : j - n);
+            double k = sqrt(kx*kx + kz*kz);
+            double xi1 = gauss(generateur), xi2 = gauss(generateur);
+            if(k == 0) {
+                continue;
+            }
+
+            double w = sqrt(OCEAN_GRAVITY*k);
+            double cosinus = (kx*ventX + kz*ventZ) / k;
+            double densite;
+            if(spectrum == OCEAN_PHILLIPS) {
+                densite = exp(-1 / (k*plusGrande*k*plusGrande)) / (k*k*k*k) * cosinus*cosinus
+                          * exp(-k*k*plusPetite*plusPetite);
+            }
+            else {
+                double sigma = w <= omegaPic ? 0.07 : 0.09;
+                double r = exp(-(w - omegaPic)*(w - omegaPic) / (2*sigma*sigma*omegaPic*omegaPic));
+                double sOmega = 0.0081*OCEAN_GRAVITY*OCEAN_GRAVITY / pow(w, 5) * exp(-1.25*pow(omegaPic / w, 4)) * pow(3.3, r);
+                // S(k) = S(omega) * domega/dk / k, spread over the half plane facing the wind
+                double etalement = cosinus > 0 ? 2 / pi * cosinus*cosinus : 0;
+                densite = sOmega * OCEAN_GRAVITY / (2*w) / k * etalement;
+            }
+
+            double amplitude = sqrt(densite * dk*dk / 2);
+            reH0[i*n + j] = xi1 * amplitude;
+            imH0[i*n + j] = xi2 * amplitude;
+            omega[i*n + j] = w;
+        }
+    }
+
+    // Scaled to a significant height of 1, significantHeight is applied when sampling
+    double variance = 0;
+    for(int i = 0; i < n*n; i++) {
+        variance += 2 * (reH0[i]*reH0[i] + imH0[i]*imH0[i]);
+    }
+    double echelle = variance > 0 ? 1 / (4*sqrt(variance)) : 0;
+    for(int i = 0; i < n*n; i++) {
+        reH0[i] *= echelle;
+        imH0[i] *= echelle;
+    }
+
+    reH0Conj.assign(n*n, 0.0f);
+    imH0Conj.assign(n*n, 0.0f);
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            int oppose = ((n - i) & (n-1))*n + ((n - j) & (n-1));
+            reH0Conj[i*n + j] = reH0[oppose];
+            imH0Conj[i*n + j] = -imH0[oppose];
+        }
+    }
+}
+
+
+void SpectralOceanWave::synthesize(double delta_t)
+{
+    OceanSpectrumTask task;
+    task.reH0 = &reH0[0];
+    task.imH0 = &imH0[0];
+    task.reH0Conj = &reH0Conj[0];
+    task.imH0Conj = &imH0Conj[0];
+    task.omega = &omega[0];
+    task.phase = &phase[0];
+    task.fft = &fft;
+    task.resolution = resolution;
+    task.dt = delta_t;
+    pool->parallelRows(task, resolution, 16);
+
+    fft.transformTransposed(true, *pool);
+}
+
+
+GLfloat SpectralOceanWave::sample(const float *plane, double x, double z) const
+{
+    int masque = resolution - 1;
+    double u = (x - waveOrigin.x) * resolution / patchSize;
+    double v = (z - waveOrigin.z) * resolution / patchSize;
+    double colonne = floor(u), ligne = floor(v);
+    double fx = u - colonne, fz = v - ligne;
+    int c0 = int(colonne) & masque, c1 = (c0 + 1) & masque;
+    const float *r0 = plane + (int(ligne) & masque)*fft.getRowStride();
+    const float *r1 = plane + ((int(ligne) + 1) & masque)*fft.getRowStride();
+    return (1-fz)*((1-fx)*r0[c0] + fx*r0[c1]) + fz*((1-fx)*r1[c0] + fx*r1[c1]);
+}
+
+
+GLfloat SpectralOceanWave::getHeight(double x, double z) const
+{
+    return significantHeight * sample(fft.real(), x, z);
+}
+
+
+GLfloat SpectralOceanWave::getVerticalSpeed(double x, double z) const
+{
+    return significantHeight * sample(fft.imag(), x, z);
+}
+
+
+GridRect SpectralOceanWave::getInfluenceRect(const GridView &grid)
+{
+    // A flat sea does not deform anything, otherwise the patch covers the whole plane
+    if(significantHeight == 0) {
+        return GridRect();
+    }
+    return Wave::getInfluenceRect(grid);
+}
+
+
+void SpectralOceanWave::deformRow(const GridView &grid, int ligne, int debut, int fin)
+{
+    // The line and its interpolation weight are the same for every point of the row
+    int masque = resolution - 1;
+    double echelle = resolution / patchSize;
+    double v = (grid.z(ligne) - waveOrigin.z) * echelle;
+    double ligneDessus = floor(v);
+    float fz = v - ligneDessus;
+    const float *r0 = fft.real() + (int(ligneDessus) & masque)*fft.getRowStride();
+    const float *r1 = fft.real() + ((int(ligneDessus) + 1) & masque)*fft.getRowStride();
+
+    GLfloat *hauteurs = grid.row(ligne);
+    double u0 = (grid.x(0) - waveOrigin.x) * echelle;
+    double du = grid.step * echelle;
+    for(int c = debut; c < fin; c++) {
+        double u = u0 + c*du;
+        double colonne = floor(u);
+        float fx = u - colonne;
+        int c0 = int(colonne) & masque, c1 = (c0 + 1) & masque;
+        float h = (1-fz)*((1-fx)*r0[c0] + fx*r0[c1]) + fz*((1-fx)*r1[c0] + fx*r1[c1]);
+        hauteurs[c] += significantHeight * h;
+    }
+}
+
+
+void SpectralOceanWave::updateWave(double delta_t, int, int)
+{
+    time += delta_t;
+    synthesize(delta_t);
+}
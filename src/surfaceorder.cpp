@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cmath>
+#include "surfaceorder.h"
+
+
+// LRU cache of the scores of optimizeVertexCache, and weights of Forsyth's article
+const int FORSYTH_CACHE_SIZE = 32;
+const double FORSYTH_CACHE_DECAY_POWER = 1.5;
+const double FORSYTH_LAST_TRIANGLE_SCORE = 0.75;
+const double FORSYTH_VALENCE_BOOST_SCALE = 2.0;
+const double FORSYTH_VALENCE_BOOST_POWER = 0.5;
+
+
+const char* getSurfaceOrderName(SurfaceOrder order)
+{
+    switch(order) {
+    case SURFACE_ORDER_STRIPS:
+        return "strips";
+    case SURFACE_ORDER_FORSYTH:
+        return "forsyth";
+    default:
+        return "rows";
+    }
+}
+
+
+// The two triangles of a cell
+static inline void addCell(std::vector<GLuint> &indices, int nbPointsX, int ligne, int colonne)
+{
+    GLuint sommet = ligne*nbPointsX + colonne;
+    indices.push_back(sommet);
+    indices.push_back(sommet + 1);
+    indices.push_back(sommet + nbPointsX);
+    indices.push_back(sommet + nbPointsX);
+    indices.push_back(sommet + nbPointsX + 1);
+    indices.push_back(sommet + 1);
+}
+
+
+void buildGridIndices(std::vector<GLuint> &indices, int nbPointsX, int nbPointsZ, SurfaceOrder order, int cacheSize)
+{
+    indices.clear();
+    if(nbPointsX < 2 || nbPointsZ < 2) {
+        return;
+    }
+    indices.reserve(6*(nbPointsX - 1)*(nbPointsZ - 1));
+
+    if(order == SURFACE_ORDER_ROWS) {
+        // Upper triangles line by line, then the lower ones : the first order of the mesh
+        for(int ligne = 0; ligne < nbPointsZ - 1; ligne++) {
+            for(int colonne = 0; colonne < nbPointsX - 1; colonne++) {
+                indices.push_back(ligne*nbPointsX + colonne);
+                indices.push_back(ligne*nbPointsX + colonne + 1);
+                indices.push_back((ligne + 1)*nbPointsX + colonne);
+            }
+        }
+        for(int ligne = 0; ligne < nbPointsZ - 1; ligne++) {
+            for(int colonne = 0; colonne < nbPointsX - 1; colonne++) {
+                indices.push_back((ligne + 1)*nbPointsX + colonne);
+                indices.push_back((ligne + 1)*nbPointsX + colonne + 1);
+                indices.push_back(ligne*nbPointsX + colonne + 1);
+            }
+        }
+        return;
+    }
+
+    // Bands of columns, line by line : the vertices of the line above, loaded by the previous line of cells, are
+    // still in the cache as long as the two lines of the band fit in it
+    int largeur = std::max(1, cacheSize / 2 - 1);
+    for(int colonneDebut = 0; colonneDebut < nbPointsX - 1; colonneDebut += largeur) {
+        int colonneFin = std::min(colonneDebut + largeur, nbPointsX - 1);
+        for(int ligne = 0; ligne < nbPointsZ - 1; ligne++) {
+            for(int colonne = colonneDebut; colonne < colonneFin; colonne++) {
+                addCell(indices, nbPointsX, ligne, colonne);
+            }
+        }
+    }
+    if(order == SURFACE_ORDER_FORSYTH) {
+        // The strips are a good start : the restarts of the greedy search follow them
+        optimizeVertexCache(indices, nbPointsX*nbPointsZ);
+    }
+}
+
+
+// Valences of the scores table, the higher ones are rare
+const int FORSYTH_MAX_VALENCE = 16;
+
+
+// Score of a vertex for the next triangle : recently used, and few triangles left to pull it back later
+static double scoreVertex(int cachePosition, int nbRemaining)
+{
+    if(nbRemaining == 0) {
+        return -1;
+    }
+    double score = 0;
+    if(cachePosition >= 0 && cachePosition < 3) {
+        // Vertices of the last triangle, whatever the one taken next
+        score = FORSYTH_LAST_TRIANGLE_SCORE;
+    }
+    else if(cachePosition >= 3) {
+        score = pow(1 - double(cachePosition - 3) / (FORSYTH_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+    }
+    return score + FORSYTH_VALENCE_BOOST_SCALE*pow(nbRemaining, -FORSYTH_VALENCE_BOOST_POWER);
+}
+
+
+// Scores of scoreVertex without the pow calls, cache positions -1 to FORSYTH_CACHE_SIZE - 1 and valences up to
+// FORSYTH_MAX_VALENCE
+class VertexScores
+{
+private:
+    double scores[FORSYTH_CACHE_SIZE + 1][FORSYTH_MAX_VALENCE + 1];
+public:
+    VertexScores()
+    {
+        for(int position = -1; position < FORSYTH_CACHE_SIZE; position++) {
+            for(int valence = 0; valence <= FORSYTH_MAX_VALENCE; valence++) {
+                scores[position + 1][valence] = scoreVertex(position, valence);
+            }
+        }
+    }
+    double operator()(int cachePosition, int nbRemaining) const
+    {
+        if(nbRemaining > FORSYTH_MAX_VALENCE) {
+            return scoreVertex(cachePosition, nbRemaining);
+        }
+        return scores[cachePosition + 1][nbRemaining];
+    }
+};
+
+
+void optimizeVertexCache(std::vector<GLuint> &indices, int nbVertices)
+{
+    int nbTriangles = indices.size() / 3;
+
+    // Triangles of every vertex : those not emitted yet are the first nbRemaining ones
+    std::vector<int> debut(nbVertices + 1, 0), triangles(indices.size()), nbRemaining(nbVertices);
+    for(int i = 0; i < int(indices.size()); i++) {
+        debut[indices[i] + 1]++;
+    }
+    for(int v = 0; v < nbVertices; v++) {
+        nbRemaining[v] = debut[v + 1];
+        debut[v + 1] += debut[v];
+    }
+    std::vector<int> curseur(debut.begin(), debut.end() - 1);
+    for(int i = 0; i < int(indices.size()); i++) {
+        triangles[curseur[indices[i]]++] = i / 3;
+    }
+
+    static const VertexScores score;
+    std::vector<int> cachePosition(nbVertices, -1);
+    std::vector<double> vertexScore(nbVertices);
+    for(int v = 0; v < nbVertices; v++) {
+        vertexScore[v] = score(-1, nbRemaining[v]);
+    }
+    std::vector<double> triangleScore(nbTriangles);
+    for(int t = 0; t < nbTriangles; t++) {
+        triangleScore[t] = vertexScore[indices[3*t]] + vertexScore[indices[3*t + 1]] + vertexScore[indices[3*t + 2]];
+    }
+
+    std::vector<char> emitted(nbTriangles, 0);
+    std::vector<GLuint> ordre;
+    ordre.reserve(indices.size());
+    std::vector<int> cache, nouveauCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nouveauCache.reserve(FORSYTH_CACHE_SIZE + 3);
+    int meilleur = -1;
+    int suivant = 0; // First triangle which may not be emitted yet, for the restarts
+    for(int n = 0; n < nbTriangles; n++) {
+        if(meilleur < 0) {
+            // No candidate around the cache : the next triangle in the input order
+            while(emitted[suivant]) {
+                suivant++;
+            }
+            meilleur = suivant;
+        }
+        emitted[meilleur] = 1;
+
+        // The vertices of the triangle go first in the cache, the others move back
+        nouveauCache.clear();
+        for(int k = 0; k < 3; k++) {
+            int v = indices[3*meilleur + k];
+            ordre.push_back(v);
+            int *premier = &triangles[debut[v]];
+            *std::find(premier, premier + nbRemaining[v], meilleur) = premier[nbRemaining[v] - 1];
+            nbRemaining[v]--;
+            nouveauCache.push_back(v);
+        }
+        for(int i = 0; i < int(cache.size()); i++) {
+            if(std::find(nouveauCache.begin(), nouveauCache.begin() + 3, cache[i]) == nouveauCache.begin() + 3) {
+                nouveauCache.push_back(cache[i]);
+            }
+        }
+        cache.swap(nouveauCache);
+
+        // Scores of the vertices whose position changed, those beyond the cache leave it
+        for(int i = 0; i < int(cache.size()); i++) {
+            int v = cache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? i : -1;
+            vertexScore[v] = score(cachePosition[v], nbRemaining[v]);
+        }
+        // Best triangle around the cache, with the new scores
+        meilleur = -1;
+        double meilleurScore = -1;
+        for(int i = 0; i < int(cache.size()); i++) {
+            int v = cache[i];
+            for(int j = debut[v]; j < debut[v] + nbRemaining[v]; j++) {
+                int t = triangles[j];
+                triangleScore[t] = vertexScore[indices[3*t]] + vertexScore[indices[3*t + 1]]
+                                   + vertexScore[indices[3*t + 2]];
+                if(i < FORSYTH_CACHE_SIZE && triangleScore[t] > meilleurScore) {
+                    meilleurScore = triangleScore[t];
+                    meilleur = t;
+                }
+            }
+        }
+        if(cache.size() > FORSYTH_CACHE_SIZE) {
+            cache.resize(FORSYTH_CACHE_SIZE);
+        }
+    }
+    indices.swap(ordre);
+}
+
+
+double computeAcmr(const std::vector<GLuint> &indices, int nbVertices, int cacheSize)
+{
+    if(indices.empty()) {
+        return 0;
+    }
+    // A vertex is in the FIFO while fewer than cacheSize vertices were loaded after it
+    std::vector<long> chargement(nbVertices, -1 - cacheSize);
+    long nbMisses = 0;
+    for(int i = 0; i < int(indices.size()); i++) {
+        if(chargement[indices[i]] < nbMisses - cacheSize) {
+            chargement[indices[i]] = nbMisses;
+            nbMisses++;
+        }
+    }
+    return double(nbMisses) / (indices.size() / 3);
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <SDL2/SDL_cpuinfo.h>
+#include "threadpool.h"
+
+
+ThreadPool::ThreadPool(int nbThreads)
+{
+    mutex = SDL_CreateMutex();
+    workReady = SDL_CreateCond();
+    workDone = SDL_CreateCond();
+    generation = 0;
+    nbActiveWorkers = 0;
+    stopping = false;
+    task = NULL;
+    nbLignes = 0;
+    bandSize = 1;
+    SDL_AtomicSet(&nextBand, 0);
+
+    startWorkers(nbThreads);
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    stopWorkers();
+    SDL_DestroyCond(workDone);
+    SDL_DestroyCond(workReady);
+    SDL_DestroyMutex(mutex);
+}
+
+
+void ThreadPool::startWorkers(int nbThreads)
+{
+    if(nbThreads <= 0) {
+        nbThreads = SDL_GetCPUCount();
+    }
+
+    stopping = false;
+    startGeneration = generation;
+    // The calling thread is the first one
+    for(int i = 1; i < nbThreads; i++) {
+        SDL_Thread *worker = SDL_CreateThread(workerMain, "WaveWorker", this);
+        if(worker == NULL) {
+            // Running with fewer threads, the result is the same
+            break;
+        }
+        workers.push_back(worker);
+    }
+}
+
+
+void ThreadPool::stopWorkers()
+{
+    SDL_LockMutex(mutex);
+    stopping = true;
+    SDL_CondBroadcast(workReady);
+    SDL_UnlockMutex(mutex);
+
+    for(size_t i = 0; i < workers.size(); i++) {
+        SDL_WaitThread(workers[i], NULL);
+    }
+    workers.clear();
+}
+
+
+void ThreadPool::setNbThreads(int nbThreads)
+{
+    stopWorkers();
+    startWorkers(nbThreads);
+}
+
+
+int ThreadPool::workerMain(void *data)
+{
+    ThreadPool *pool = static_cast<ThreadPool*>(data);
+
+    SDL_LockMutex(pool->mutex);
+    // Not the current generation : work may have been posted before this thread got here
+    int seenGeneration = pool->startGeneration;
+    while(true) {
+        while(pool->generation == seenGeneration && !pool->stopping) {
+            SDL_CondWait(pool->workReady, pool->mutex);
+        }
+        if(pool->stopping) {
+            break;
+        }
+        seenGeneration = pool->generation;
+        SDL_UnlockMutex(pool->mutex);
+
+        pool->runBands();
+
+        SDL_LockMutex(pool->mutex);
+        pool->nbActiveWorkers--;
+        if(pool->nbActiveWorkers == 0) {
+            SDL_CondSignal(pool->workDone);
+        }
+    }
+    SDL_UnlockMutex(pool->mutex);
+
+    return 0;
+}
+
+
+void ThreadPool::runBands()
+{
+    int nbBands = (nbLignes + bandSize - 1) / bandSize;
+    int band;
+
+    // SDL_AtomicAdd returns the previous value : each band is taken exactly once
+    while((band = SDL_AtomicAdd(&nextBand, 1)) < nbBands) {
+        int ligneDebut = band * bandSize;
+        int ligneFin = std::min(ligneDebut + bandSize, nbLignes);
+        task->run(ligneDebut, ligneFin);
+    }
+}
+
+
+void ThreadPool::parallelRows(RowTask &task, int nbLignes, int bandSize)
+{
+    if(bandSize < 1) {
+        bandSize = 1;
+    }
+
+    // Not worth waking the workers up
+    if(workers.empty() || nbLignes <= bandSize) {
+        for(int ligne = 0; ligne < nbLignes; ligne += bandSize) {
+            task.run(ligne, std::min(ligne + bandSize, nbLignes));
+        }
+        return;
+    }
+
+    SDL_LockMutex(mutex);
+    this->task = &task;
+    this->nbLignes = nbLignes;
+    this->bandSize = bandSize;
+    SDL_AtomicSet(&nextBand, 0);
+    nbActiveWorkers = workers.size();
+    generation++;
+    SDL_CondBroadcast(workReady);
+    SDL_UnlockMutex(mutex);
+
+    runBands();
+
+    SDL_LockMutex(mutex);
+    while(nbActiveWorkers > 0) {
+        SDL_CondWait(workDone, mutex);
+    }
+    SDL_UnlockMutex(mutex);
+}
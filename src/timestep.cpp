@@ -0,0 +1,37 @@
+#include <algorithm>
+#include <cmath>
+#include "timestep.h"
+
+
+FixedTimestep::FixedTimestep(double stepDuration, int maxSteps)
+{
+    this->stepDuration = stepDuration;
+    this->maxSteps = maxSteps;
+    accumulator = 0;
+    droppedTime = 0;
+}
+
+
+void FixedTimestep::setStepDuration(double d)
+{
+    stepDuration = d;
+    if(accumulator >= stepDuration) {
+        droppedTime += accumulator - stepDuration;
+        accumulator = stepDuration;
+    }
+}
+
+
+int FixedTimestep::advance(double elapsed)
+{
+    accumulator += elapsed;
+    double nbSteps = floor(accumulator / stepDuration);
+    accumulator -= nbSteps*stepDuration;
+    // Rounding of the division
+    accumulator = std::min(std::max(accumulator, 0.0), stepDuration);
+    if(nbSteps > maxSteps) {
+        droppedTime += (nbSteps - maxSteps)*stepDuration;
+        nbSteps = maxSteps;
+    }
+    return nbSteps;
+}
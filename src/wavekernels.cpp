@@ -0,0 +1,978 @@
+#include <algorithm>
+#include <cmath>
+#include <SDL2/SDL_atomic.h>
+#include "wavekernels.h"
+
+// The vectorized kernels are only built with GCC on x86, other builds keep the scalar reference
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define WAVE_KERNELS_SIMD
+#include <immintrin.h>
+#endif
+
+
+ConicKernelParams::ConicKernelParams(float ox, float oz, float r, float h)
+{
+    originX = ox;
+    originZ = oz;
+    radius = r;
+    height = h;
+    pente = fabs(h / r);
+}
+
+
+CircularKernelParams::CircularKernelParams(float ox, float oz, float r, float w, float h, float epsilon)
+{
+    double pi = 3.1415;
+
+    originX = ox;
+    originZ = oz;
+    radius = r;
+    width = w;
+    height = h;
+    amortissement = -0.05;
+    pulsation = pi / w;
+    reach = r + w/2;
+    if(epsilon > 0) {
+        reach = std::min(double(reach), std::max(0.0, log(fabs(h) / epsilon) / -amortissement));
+    }
+    profileOffset = -1;
+    nbProfileSamples = 0;
+    profileScale = 0;
+}
+
+
+WaveEquationParams::WaveEquationParams(double waveSpeed, double step, double stiffness, double damping,
+                                       double sourceGain, double dt)
+{
+    c2SurDx2 = waveSpeed*waveSpeed / (step*step);
+    centre = 4*c2SurDx2 + stiffness;
+    this->damping = damping;
+    this->sourceGain = sourceGain;
+    this->dt = dt;
+}
+
+
+void WaveBatch::addCircular(const CircularKernelParams &params)
+{
+    circulars.push_back(params);
+    if(getWaveKernels().tier != WAVE_MATH_TABLE || getWaveKernels().isa == WAVE_KERNEL_SCALAR) {
+        return;
+    }
+
+    CircularKernelParams &added = circulars.back();
+    double scale = CIRCULAR_PROFILE_SAMPLES / params.width;
+    // One more sample beyond the reach for the interpolation
+    double nbSamples = ceil(params.reach*scale) + 2;
+    if(!(nbSamples <= CIRCULAR_PROFILE_MAX_SAMPLES)) {
+        return;
+    }
+    added.profileOffset = circularProfiles.size();
+    added.nbProfileSamples = nbSamples;
+    added.profileScale = scale;
+    for(int i = 0; i < added.nbProfileSamples; i++) {
+        double distance = i / scale;
+        circularProfiles.push_back(params.height*exp(params.amortissement*distance)
+                                   *cos(params.pulsation*(distance - params.radius)));
+    }
+}
+
+
+void WaveBatch::addGerstner(const GerstnerKernelParams &component)
+{
+    for(size_t i = 0; i < gerstners.size(); i++) {
+        GerstnerKernelParams &existant = gerstners[i];
+        if(existant.kx == component.kx && existant.kz == component.kz) {
+            existant.reVertical += component.reVertical;
+            existant.imVertical += component.imVertical;
+            existant.reHorizontalX += component.reHorizontalX;
+            existant.imHorizontalX += component.imHorizontalX;
+            existant.reHorizontalZ += component.reHorizontalZ;
+            existant.imHorizontalZ += component.imHorizontalZ;
+            return;
+        }
+    }
+    gerstners.push_back(component);
+}
+
+
+void PlaneWaveTables::resize(int nbComponents, int nbColonnes, int nbLignes)
+{
+    this->nbComponents = nbComponents;
+    this->nbColonnes = nbColonnes;
+    this->nbLignes = nbLignes;
+    cosX.resize(nbComponents*nbColonnes);
+    sinX.resize(nbComponents*nbColonnes);
+    coefCos.resize(nbLignes*nbComponents);
+    coefSin.resize(nbLignes*nbComponents);
+}
+
+
+void PlaneWaveTables::build(const PlaneWaveParams *planes, int debut, int fin, double x0, double z0, double step)
+{
+    for(int k = debut; k < fin; k++) {
+        const PlaneWaveParams &p = planes[k];
+        for(int colonne = 0; colonne < nbColonnes; colonne++) {
+            double angle = p.kx*(x0 + colonne*step);
+            cosX[k*nbColonnes + colonne] = cos(angle);
+            sinX[k*nbColonnes + colonne] = sin(angle);
+        }
+        for(int ligne = 0; ligne < nbLignes; ligne++) {
+            double angle = p.kz*(z0 + ligne*step) + p.phase;
+            coefCos[ligne*nbComponents + k] = p.amplitude*cos(angle);
+            coefSin[ligne*nbComponents + k] = -p.amplitude*sin(angle);
+        }
+    }
+}
+
+
+/***************************************************************************/
+/* Scalar reference kernels                                                */
+/***************************************************************************/
+static void scalarConicRow(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                           const ConicKernelParams &params)
+{
+    double dz = z - params.originZ;
+
+    for(int colonne = debut; colonne < fin; colonne++) {
+        double dx = x0 + colonne*step - params.originX;
+        //Searching points in the radius
+        GLfloat distanceToOrigin = sqrt(dx*dx + dz*dz);
+
+        if(distanceToOrigin <= params.radius) {
+            hauteurs[colonne] += - params.pente*distanceToOrigin + params.height;
+        }
+    }
+}
+
+
+static void scalarCircularRow(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                              const CircularKernelParams &params)
+{
+    double dz = z - params.originZ;
+
+    for(int colonne = debut; colonne < fin; colonne++) {
+        double dx = x0 + colonne*step - params.originX;
+        //Searching points before and after the radius (+ and - width)
+        GLfloat distanceToOrigin = sqrt(dx*dx + dz*dz);
+
+        if(distanceToOrigin <= params.reach) {
+            hauteurs[colonne] += (params.height*exp(params.amortissement*distanceToOrigin))
+                                 *cos(params.pulsation*(distanceToOrigin-params.radius));
+        }
+    }
+}
+
+
+// Stencil on the columns [debut, fin[ of a line of nbPoints points
+static void scalarWaveEquationSpan(GLfloat *speeds, GLfloat *accelerations, const GLfloat *hauteurs,
+                                   const GLfloat *dessus, const GLfloat *dessous, const GLfloat *sources,
+                                   int debut, int fin, int nbPoints, const WaveEquationParams &params)
+{
+    for(int colonne = debut; colonne < fin; colonne++) {
+        // Reflecting borders : the missing neighbour is the point itself
+        GLfloat gauche = hauteurs[colonne > 0 ? colonne-1 : colonne];
+        GLfloat droite = hauteurs[colonne < nbPoints-1 ? colonne+1 : colonne];
+        GLfloat voisins = gauche + droite + dessus[colonne] + dessous[colonne];
+        GLfloat acceleration = params.c2SurDx2*voisins - params.centre*hauteurs[colonne] - params.damping*speeds[colonne];
+        if(sources != NULL) {
+            acceleration += params.sourceGain*sources[colonne];
+        }
+        accelerations[colonne] = acceleration;
+        speeds[colonne] += acceleration*params.dt;
+    }
+}
+
+
+static void scalarWaveEquationRow(GLfloat *speeds, GLfloat *accelerations, const GLfloat *hauteurs,
+                                  const GLfloat *dessus, const GLfloat *dessous, const GLfloat *sources,
+                                  int nbPoints, const WaveEquationParams &params)
+{
+    scalarWaveEquationSpan(speeds, accelerations, hauteurs, dessus, dessous, sources, 0, nbPoints, nbPoints, params);
+}
+
+
+static void scalarIntegrateRow(GLfloat *hauteurs, const GLfloat *speeds, int nbPoints, float dt)
+{
+    for(int colonne = 0; colonne < nbPoints; colonne++) {
+        hauteurs[colonne] += speeds[colonne]*dt;
+    }
+}
+
+
+// Rusanov flux across the face between the cells L and R, with the depths rebuilt on the highest of the two
+// beds (hydrostatic reconstruction) : a lake at rest stays at rest over any bathymetry and no depth gets negative
+// qn is the momentum normal to the face, qt the tangential one
+static void scalarShallowWaterFace(double hL, double qnL, double qtL, double bL,
+                                   double hR, double qnR, double qtR, double bR,
+                                   const ShallowWaterParams &params, const ShallowWaterFluxes &flux, int i)
+{
+    double g = params.gravity;
+    double fond = std::max(bL, bR);
+    double hEtoileL = std::max(0.0, hL + bL - fond);
+    double hEtoileR = std::max(0.0, hR + bR - fond);
+    double uL = hL > params.dry ? qnL / hL : 0, vL = hL > params.dry ? qtL / hL : 0;
+    double uR = hR > params.dry ? qnR / hR : 0, vR = hR > params.dry ? qtR / hR : 0;
+    double a = std::max(fabs(uL) + sqrt(g*hEtoileL), fabs(uR) + sqrt(g*hEtoileR));
+
+    double qL = hEtoileL*uL, qR = hEtoileR*uR;
+    double pressionL = 0.5*g*hEtoileL*hEtoileL, pressionR = 0.5*g*hEtoileR*hEtoileR;
+    double normal = 0.5*(qL*uL + pressionL + qR*uR + pressionR) - 0.5*a*(qR - qL);
+    flux.masse[i] = 0.5*(qL + qR) - 0.5*a*(hEtoileR - hEtoileL);
+    flux.normalGauche[i] = normal + 0.5*g*hL*hL - pressionL;
+    flux.normalDroite[i] = normal + 0.5*g*hR*hR - pressionR;
+    flux.tangente[i] = 0.5*(qL*vL + qR*vR) - 0.5*a*(hEtoileR*vR - hEtoileL*vL);
+}
+
+
+// Faces faceDebut..faceFin-1 of a line, face k being between the columns k-1 and k
+static void scalarShallowWaterFluxXSpan(const ShallowWaterRow &ligne, int debut, int faceDebut, int faceFin, int nbPoints,
+                                        const ShallowWaterParams &params, const ShallowWaterFluxes &flux)
+{
+    for(int face = faceDebut; face < faceFin; face++) {
+        // Walls : the missing cell is the mirror of its neighbour
+        int gauche = face > 0 ? face-1 : 0;
+        int droite = face < nbPoints ? face : nbPoints-1;
+        double signeGauche = face > 0 ? 1 : -1;
+        double signeDroite = face < nbPoints ? 1 : -1;
+        scalarShallowWaterFace(ligne.depth[gauche], signeGauche*ligne.momentumX[gauche], ligne.momentumZ[gauche], ligne.bed[gauche],
+                               ligne.depth[droite], signeDroite*ligne.momentumX[droite], ligne.momentumZ[droite], ligne.bed[droite],
+                               params, flux, face - debut);
+    }
+}
+
+
+static void scalarShallowWaterFluxX(const ShallowWaterRow &ligne, int debut, int fin, int nbPoints,
+                                    const ShallowWaterParams &params, const ShallowWaterFluxes &flux)
+{
+    scalarShallowWaterFluxXSpan(ligne, debut, debut, fin+1, nbPoints, params, flux);
+}
+
+
+static void scalarShallowWaterFluxZSpan(const ShallowWaterRow &haut, const ShallowWaterRow &bas, float signeHaut,
+                                        float signeBas, int debut, int colonneDebut, int colonneFin,
+                                        const ShallowWaterParams &params, const ShallowWaterFluxes &flux)
+{
+    for(int colonne = colonneDebut; colonne < colonneFin; colonne++) {
+        scalarShallowWaterFace(haut.depth[colonne], signeHaut*haut.momentumZ[colonne], haut.momentumX[colonne], haut.bed[colonne],
+                               bas.depth[colonne], signeBas*bas.momentumZ[colonne], bas.momentumX[colonne], bas.bed[colonne],
+                               params, flux, colonne - debut);
+    }
+}
+
+
+static void scalarShallowWaterFluxZ(const ShallowWaterRow &haut, const ShallowWaterRow &bas, float signeHaut,
+                                    float signeBas, int debut, int fin, const ShallowWaterParams &params,
+                                    const ShallowWaterFluxes &flux)
+{
+    scalarShallowWaterFluxZSpan(haut, bas, signeHaut, signeBas, debut, debut, fin, params, flux);
+}
+
+
+static float scalarShallowWaterUpdateSpan(const ShallowWaterRow &ancien, GLfloat *depth, GLfloat *momentumX,
+                                          GLfloat *momentumZ, const ShallowWaterFluxes &x, const ShallowWaterFluxes &haut,
+                                          const ShallowWaterFluxes &bas, int debut, int colonneDebut, int colonneFin,
+                                          const ShallowWaterParams &params)
+{
+    double vitesseMax = 0;
+    for(int colonne = colonneDebut; colonne < colonneFin; colonne++) {
+        int i = colonne - debut;
+        double h = ancien.depth[colonne] - params.dtSurDx*(x.masse[i+1] - x.masse[i] + bas.masse[i] - haut.masse[i]);
+        double qx = ancien.momentumX[colonne] - params.dtSurDx*(x.normalGauche[i+1] - x.normalDroite[i]
+                                                                + bas.tangente[i] - haut.tangente[i]);
+        double qz = ancien.momentumZ[colonne] - params.dtSurDx*(x.tangente[i+1] - x.tangente[i]
+                                                                + bas.normalGauche[i] - haut.normalDroite[i]);
+        // Drying cell : the water left stays still
+        if(h <= params.dry) {
+            h = std::max(h, 0.0);
+            qx = 0;
+            qz = 0;
+        }
+        depth[colonne] = h;
+        momentumX[colonne] = qx;
+        momentumZ[colonne] = qz;
+
+        if(h > params.dry) {
+            vitesseMax = std::max(vitesseMax, std::max(fabs(qx), fabs(qz)) / h + sqrt(params.gravity*h));
+        }
+    }
+    return vitesseMax;
+}
+
+
+static float scalarShallowWaterUpdate(const ShallowWaterRow &ancien, GLfloat *depth, GLfloat *momentumX,
+                                      GLfloat *momentumZ, const ShallowWaterFluxes &x, const ShallowWaterFluxes &haut,
+                                      const ShallowWaterFluxes &bas, int debut, int fin, const ShallowWaterParams &params)
+{
+    return scalarShallowWaterUpdateSpan(ancien, depth, momentumX, momentumZ, x, haut, bas, debut, debut, fin, params);
+}
+
+
+static void scalarFftButterfly4Span(const FftButterfly &b, int debut, int fin)
+{
+    for(int c = debut; c < fin; c++) {
+        float apcR = b.reEntree[0][c] + b.reEntree[2][c], apcI = b.imEntree[0][c] + b.imEntree[2][c];
+        float amcR = b.reEntree[0][c] - b.reEntree[2][c], amcI = b.imEntree[0][c] - b.imEntree[2][c];
+        float bpdR = b.reEntree[1][c] + b.reEntree[3][c], bpdI = b.imEntree[1][c] + b.imEntree[3][c];
+        // sens * i * (b-d)
+        float jR = -b.sens*(b.imEntree[1][c] - b.imEntree[3][c]);
+        float jI = b.sens*(b.reEntree[1][c] - b.reEntree[3][c]);
+
+        float t1R = amcR + jR, t1I = amcI + jI;
+        float t2R = apcR - bpdR, t2I = apcI - bpdI;
+        float t3R = amcR - jR, t3I = amcI - jI;
+        b.reSortie[0][c] = apcR + bpdR;
+        b.imSortie[0][c] = apcI + bpdI;
+        b.reSortie[1][c] = b.reW[0]*t1R - b.imW[0]*t1I;
+        b.imSortie[1][c] = b.reW[0]*t1I + b.imW[0]*t1R;
+        b.reSortie[2][c] = b.reW[1]*t2R - b.imW[1]*t2I;
+        b.imSortie[2][c] = b.reW[1]*t2I + b.imW[1]*t2R;
+        b.reSortie[3][c] = b.reW[2]*t3R - b.imW[2]*t3I;
+        b.imSortie[3][c] = b.reW[2]*t3I + b.imW[2]*t3R;
+    }
+}
+
+
+static void scalarFftButterfly2(const FftButterfly &b, int debut, int fin)
+{
+    for(int c = debut; c < fin; c++) {
+        float aR = b.reEntree[0][c], aI = b.imEntree[0][c];
+        float bR = b.reEntree[1][c], bI = b.imEntree[1][c];
+        b.reSortie[0][c] = aR + bR;
+        b.imSortie[0][c] = aI + bI;
+        b.reSortie[1][c] = aR - bR;
+        b.imSortie[1][c] = aI - bI;
+    }
+}
+
+
+static void scalarOceanSpectrumSpan(const OceanSpectrumRow &row, int debut, int fin, float dt)
+{
+    const double deuxPi = 2*3.14159265358979323846;
+    for(int k = debut; k < fin; k++) {
+        double phase = row.phase[k] + row.omega[k]*dt;
+        phase -= deuxPi*floor(phase / deuxPi);
+        row.phase[k] = phase;
+
+        double c = cos(phase), s = sin(phase);
+        // a = h0(k) e^(i phase), b = conj(h0(-k)) e^(-i phase), h = a + b and dh/dt = i omega (a - b)
+        double aR = row.reH0[k]*c - row.imH0[k]*s, aI = row.reH0[k]*s + row.imH0[k]*c;
+        double bR = row.reH0Conj[k]*c + row.imH0Conj[k]*s, bI = row.imH0Conj[k]*c - row.reH0Conj[k]*s;
+        // h + i*dh/dt = (a + b) - omega (a - b)
+        row.reSortie[k] = aR + bR - row.omega[k]*(aR - bR);
+        row.imSortie[k] = aI + bI - row.omega[k]*(aI - bI);
+    }
+}
+
+
+static void scalarFftButterfly4(const FftButterfly &b, int debut, int fin)
+{
+    scalarFftButterfly4Span(b, debut, fin);
+}
+
+
+template<class Colormap>
+static void scalarColorizeRow(const GLfloat *hauteurs, GLuint *couleurs, int nbPoints)
+{
+    for(int colonne = 0; colonne < nbPoints; colonne++) {
+        couleurs[colonne] = Colormap::color(hauteurs[colonne]);
+    }
+}
+
+
+// Nearest color of the table of the colormap, for the lines shorter than a vector of the SIMD kernels
+template<class Colormap>
+static void tableColorizeRow(const GLfloat *hauteurs, GLuint *couleurs, int nbPoints)
+{
+    const float echelle = (COLORMAP_SIZE - 1) / (COLORMAP_MAX_HEIGHT - COLORMAP_MIN_HEIGHT);
+    for(int colonne = 0; colonne < nbPoints; colonne++) {
+        float index = std::min(std::max((hauteurs[colonne] - COLORMAP_MIN_HEIGHT)*echelle, 0.0f),
+                               float(COLORMAP_SIZE - 1));
+        couleurs[colonne] = colormapTable<Colormap>.couleurs[int(index + 0.5f)];
+    }
+}
+
+
+static void scalarOceanSpectrumRow(const OceanSpectrumRow &row, int nbPoints, float dt)
+{
+    scalarOceanSpectrumSpan(row, 0, nbPoints, dt);
+}
+
+
+static void scalarGerstnerRow(GLfloat *hauteurs, GLfloat *deplacementsX, GLfloat *deplacementsZ, int debut, int fin,
+                              double x0, double step, double z, const GerstnerKernelParams *components,
+                              int nbComponents)
+{
+    for(int colonne = debut; colonne < fin; colonne++) {
+        double x = x0 + colonne*step;
+        double h = 0, dx = 0, dz = 0;
+        for(int i = 0; i < nbComponents; i++) {
+            const GerstnerKernelParams &g = components[i];
+            double theta = g.kx*x + g.kz*z;
+            double c = cos(theta), s = sin(theta);
+            h += g.reVertical*s + g.imVertical*c;
+            dx += g.reHorizontalX*c - g.imHorizontalX*s;
+            dz += g.reHorizontalZ*c - g.imHorizontalZ*s;
+        }
+        hauteurs[colonne] += h;
+        if(deplacementsX != NULL) {
+            deplacementsX[colonne] += dx;
+            deplacementsZ[colonne] += dz;
+        }
+    }
+}
+
+
+// Sum of the separable products in double precision, one point at a time, on the columns [debut, fin[
+static void scalarPlaneWaveSpan(GLfloat *hauteurs, int rowStride, int ligneDebut, int ligneFin, int debut, int fin,
+                                const PlaneWaveTables &tables)
+{
+    for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+        const float *coefCos = &tables.coefCos[ligne*tables.nbComponents];
+        const float *coefSin = &tables.coefSin[ligne*tables.nbComponents];
+        for(int colonne = debut; colonne < fin; colonne++) {
+            double h = 0;
+            for(int k = 0; k < tables.nbComponents; k++) {
+                h += (double)tables.cosX[k*tables.nbColonnes + colonne]*coefCos[k]
+                     + (double)tables.sinX[k*tables.nbColonnes + colonne]*coefSin[k];
+            }
+            hauteurs[ligne*rowStride + colonne] += h;
+        }
+    }
+}
+
+static void scalarPlaneWaveRows(GLfloat *hauteurs, int rowStride, int ligneDebut, int ligneFin,
+                                const PlaneWaveTables &tables)
+{
+    scalarPlaneWaveSpan(hauteurs, rowStride, ligneDebut, ligneFin, 0, tables.nbColonnes, tables);
+}
+
+
+static void scalarPhasorRow(GLfloat *hauteurs, const GLfloat *re, const GLfloat *im, int nbPoints,
+                            float cosTheta, float sinTheta)
+{
+    for(int colonne = 0; colonne < nbPoints; colonne++) {
+        hauteurs[colonne] += re[colonne]*cosTheta + im[colonne]*sinTheta;
+    }
+}
+
+
+static void scalarExpRow(const GLfloat *x, GLfloat *y, int nbPoints)
+{
+    for(int i = 0; i < nbPoints; i++) {
+        y[i] = std::exp(x[i]);
+    }
+}
+
+static void scalarCosRow(const GLfloat *x, GLfloat *y, int nbPoints)
+{
+    for(int i = 0; i < nbPoints; i++) {
+        y[i] = std::cos(x[i]);
+    }
+}
+
+
+/***************************************************************************/
+/* Fused evaluation helpers                                                */
+/***************************************************************************/
+// Number of waves crossing a row whose spans are kept together on the stack by the fused kernels (10 KB) : the row is
+// loaded and stored once per group
+const int FUSED_GROUP_SIZE = 256;
+// Gerstner components whose e^(i theta) are kept together on the stack, and columns between two exact evaluations
+const int GERSTNER_GROUP_SIZE = 16;
+const int GERSTNER_TILE_COLUMNS = 256;
+// Lines of the plane wave kernels whose sums are kept in registers
+const int PLANE_WAVE_LINES = 8;
+
+// A wave of a batch crossing the row being evaluated
+class FusedWave
+{
+public:
+    const ConicKernelParams *conic; // One of the two is NULL
+    const CircularKernelParams *circular;
+    const float *profile; // Radial profile of the circular wave, NULL to evaluate exp and cos
+    float originX;
+    float dz2; // Squared distance between the row and the wave origin
+    int debut, fin; // Columns of the row within the wave reach
+};
+
+
+// Finds the columns of [debut, fin[ the wave number w of the batch can deform on the row at z
+static bool fusedWaveSpan(const WaveBatch &batch, int w, int debut, int fin, double x0, double step, double z,
+                          FusedWave *active)
+{
+    double originX, originZ, reach;
+    if(w < int(batch.conics.size())) {
+        const ConicKernelParams &params = batch.conics[w];
+        active->conic = &params;
+        active->circular = NULL;
+        active->profile = NULL;
+        originX = params.originX;
+        originZ = params.originZ;
+        reach = params.radius;
+    }
+    else {
+        const CircularKernelParams &params = batch.circulars[w - batch.conics.size()];
+        active->conic = NULL;
+        active->circular = &params;
+        active->profile = params.profileOffset >= 0 ? &batch.circularProfiles[params.profileOffset] : NULL;
+        originX = params.originX;
+        originZ = params.originZ;
+        reach = params.reach;
+    }
+
+    double dz = z - originZ;
+    if(!(fabs(dz) <= reach)) {
+        return false;
+    }
+
+    // Chord of the disc on this row, widened a little to keep the points on the border
+    double demiCorde = sqrt(reach*reach - dz*dz);
+    double premiere = ceil((originX - demiCorde - x0) / step - 1e-4);
+    double derniere = floor((originX + demiCorde - x0) / step + 1e-4);
+    active->debut = premiere < debut ? debut : (premiere > fin ? fin : int(premiere));
+    active->fin = derniere < debut ? debut : (derniere >= fin ? fin : int(derniere) + 1);
+    active->originX = originX;
+    active->dz2 = dz*dz;
+
+    return active->debut < active->fin;
+}
+
+
+// Points of the active waves from colonne on, with the scalar reference
+static void scalarFusedTail(GLfloat *hauteurs, int colonne, double x0, double step, double z,
+                            const FusedWave *actives, int nbActives)
+{
+    for(int a = 0; a < nbActives; a++) {
+        int debut = std::max(colonne, actives[a].debut);
+        if(debut < actives[a].fin) {
+            if(actives[a].conic != NULL) {
+                scalarConicRow(hauteurs, debut, actives[a].fin, x0, step, z, *actives[a].conic);
+            }
+            else {
+                scalarCircularRow(hauteurs, debut, actives[a].fin, x0, step, z, *actives[a].circular);
+            }
+        }
+    }
+}
+
+
+// No registers to keep the heights in : every wave is applied to its span of the row in turn
+static void scalarFusedRow(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                           const WaveBatch &batch)
+{
+    FusedWave active;
+    int nbWaves = batch.conics.size() + batch.circulars.size();
+
+    for(int w = 0; w < nbWaves; w++) {
+        if(fusedWaveSpan(batch, w, debut, fin, x0, step, z, &active)) {
+            scalarFusedTail(hauteurs, active.debut, x0, step, z, &active, 1);
+        }
+    }
+}
+
+
+#ifdef WAVE_KERNELS_SIMD
+
+/***************************************************************************/
+/* SSE2 : 4 points per instruction                                         */
+/***************************************************************************/
+#pragma GCC push_options
+#pragma GCC target("sse2")
+namespace sse2
+{
+class Simd
+{
+public:
+    typedef __m128 V;
+    typedef __m128 Mask;
+    static const int LANES = 4;
+    static V load(const float *p) {return _mm_loadu_ps(p);}
+    static void store(float *p, V a) {_mm_storeu_ps(p, a);}
+    static V set1(float a) {return _mm_set1_ps(a);}
+    static V ramp() {return _mm_setr_ps(0, 1, 2, 3);}
+    static V add(V a, V b) {return _mm_add_ps(a, b);}
+    static V sub(V a, V b) {return _mm_sub_ps(a, b);}
+    static V mul(V a, V b) {return _mm_mul_ps(a, b);}
+    static V madd(V a, V b, V c) {return _mm_add_ps(_mm_mul_ps(a, b), c);}
+    static V div(V a, V b) {return _mm_div_ps(a, b);}
+    static V max(V a, V b) {return _mm_max_ps(a, b);}
+    static V min(V a, V b) {return _mm_min_ps(a, b);}
+    static V sqrt(V a) {return _mm_sqrt_ps(a);}
+    // No rounding instruction before SSE4.1 : conversion to integers, valid for |a| < 2^31
+    static V round(V a) {return _mm_cvtepi32_ps(_mm_cvtps_epi32(a));}
+    static V floor(V a)
+    {
+        V t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+    }
+    static V pow2n(V n)
+    {
+        __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+        return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+    }
+    static Mask lessEqual(V a, V b) {return _mm_cmple_ps(a, b);}
+    static V select(Mask m, V a, V b) {return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));}
+    // base[index] for non negative indices, no gather instruction before AVX2
+    static V gather(const float *base, V index)
+    {
+        int i[4];
+        _mm_storeu_si128((__m128i*)i, _mm_cvttps_epi32(index));
+        return _mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+    }
+    static V gatherBits(const GLuint *base, V index)
+    {
+        int i[4];
+        _mm_storeu_si128((__m128i*)i, _mm_cvttps_epi32(index));
+        return _mm_castsi128_ps(_mm_setr_epi32(base[i[0]], base[i[1]], base[i[2]], base[i[3]]));
+    }
+};
+
+#include "wavekernels_simd.h"
+}
+#pragma GCC pop_options
+
+
+/***************************************************************************/
+/* AVX2 + FMA : 8 points per instruction                                   */
+/***************************************************************************/
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+namespace avx2
+{
+class Simd
+{
+public:
+    typedef __m256 V;
+    typedef __m256 Mask;
+    static const int LANES = 8;
+    static V load(const float *p) {return _mm256_loadu_ps(p);}
+    static void store(float *p, V a) {_mm256_storeu_ps(p, a);}
+    static V set1(float a) {return _mm256_set1_ps(a);}
+    static V ramp() {return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);}
+    static V add(V a, V b) {return _mm256_add_ps(a, b);}
+    static V sub(V a, V b) {return _mm256_sub_ps(a, b);}
+    static V mul(V a, V b) {return _mm256_mul_ps(a, b);}
+    static V madd(V a, V b, V c) {return _mm256_fmadd_ps(a, b, c);}
+    static V div(V a, V b) {return _mm256_div_ps(a, b);}
+    static V max(V a, V b) {return _mm256_max_ps(a, b);}
+    static V min(V a, V b) {return _mm256_min_ps(a, b);}
+    static V sqrt(V a) {return _mm256_sqrt_ps(a);}
+    static V round(V a) {return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);}
+    static V floor(V a) {return _mm256_floor_ps(a);}
+    static V pow2n(V n)
+    {
+        __m256i e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+    }
+    static Mask lessEqual(V a, V b) {return _mm256_cmp_ps(a, b, _CMP_LE_OQ);}
+    static V select(Mask m, V a, V b) {return _mm256_blendv_ps(b, a, m);}
+    static V gather(const float *base, V index) {return _mm256_i32gather_ps(base, _mm256_cvttps_epi32(index), 4);}
+    static V gatherBits(const GLuint *base, V index)
+    {
+        return _mm256_castsi256_ps(_mm256_i32gather_epi32((const int*)base, _mm256_cvttps_epi32(index), 4));
+    }
+};
+
+#include "wavekernels_simd.h"
+}
+#pragma GCC pop_options
+
+
+/***************************************************************************/
+/* AVX-512F : 16 points per instruction                                    */
+/***************************************************************************/
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+namespace avx512
+{
+class Simd
+{
+public:
+    typedef __m512 V;
+    typedef __mmask16 Mask;
+    static const int LANES = 16;
+    static V load(const float *p) {return _mm512_loadu_ps(p);}
+    static void store(float *p, V a) {_mm512_storeu_ps(p, a);}
+    static V set1(float a) {return _mm512_set1_ps(a);}
+    static V ramp() {return _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);}
+    static V add(V a, V b) {return _mm512_add_ps(a, b);}
+    static V sub(V a, V b) {return _mm512_sub_ps(a, b);}
+    static V mul(V a, V b) {return _mm512_mul_ps(a, b);}
+    static V madd(V a, V b, V c) {return _mm512_fmadd_ps(a, b, c);}
+    static V div(V a, V b) {return _mm512_div_ps(a, b);}
+    // The unmasked forms of GCC pass an uninitialized vector as the source of the masked lanes : the zero-masked
+    // ones, with every lane set, compile to the same instructions from initialized values
+    static const Mask ALL = 0xFFFF;
+    static V max(V a, V b) {return _mm512_maskz_max_ps(ALL, a, b);}
+    static V min(V a, V b) {return _mm512_maskz_min_ps(ALL, a, b);}
+    static V sqrt(V a) {return _mm512_maskz_sqrt_ps(ALL, a);}
+    static V round(V a) {return _mm512_maskz_roundscale_ps(ALL, a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);}
+    static V floor(V a) {return _mm512_maskz_roundscale_ps(ALL, a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);}
+    static __m512i truncate(V a) {return _mm512_maskz_cvttps_epi32(ALL, a);}
+    static V pow2n(V n)
+    {
+        __m512i e = _mm512_add_epi32(_mm512_maskz_cvtps_epi32(ALL, n), _mm512_set1_epi32(127));
+        return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(ALL, e, 23));
+    }
+    static Mask lessEqual(V a, V b) {return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ);}
+    static V select(Mask m, V a, V b) {return _mm512_mask_blend_ps(m, b, a);}
+    static V gather(const float *base, V index)
+    {
+        return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), ALL, truncate(index), base, 4);
+    }
+    static V gatherBits(const GLuint *base, V index)
+    {
+        return _mm512_castsi512_ps(_mm512_mask_i32gather_epi32(_mm512_setzero_si512(), ALL, truncate(index), base, 4));
+    }
+};
+
+#include "wavekernels_simd.h"
+}
+#pragma GCC pop_options
+
+#endif // WAVE_KERNELS_SIMD
+
+
+/***************************************************************************/
+/* Runtime selection                                                       */
+/***************************************************************************/
+static bool isaSupported(WaveKernelIsa isa)
+{
+#ifdef WAVE_KERNELS_SIMD
+    __builtin_cpu_init();
+    switch(isa) {
+    case WAVE_KERNEL_SCALAR:
+        return true;
+    case WAVE_KERNEL_SSE2:
+        return __builtin_cpu_supports("sse2");
+    case WAVE_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case WAVE_KERNEL_AVX512:
+        return __builtin_cpu_supports("avx512f");
+    }
+    return false;
+#else
+    return isa == WAVE_KERNEL_SCALAR;
+#endif
+}
+
+
+static WaveKernels makeWaveKernels(WaveKernelIsa isa, WaveMathTier tier)
+{
+    WaveKernels kernels;
+    kernels.isa = isa;
+    kernels.tier = tier;
+
+    switch(isa) {
+#ifdef WAVE_KERNELS_SIMD
+    case WAVE_KERNEL_SSE2:
+        kernels.conicRow = sse2::conicRow;
+        kernels.circularRow = sse2::circularRowKernel(tier);
+        kernels.fusedRow = sse2::fusedRowKernel(tier);
+        kernels.gerstnerRow = sse2::gerstnerRow;
+        kernels.planeWaveRows = sse2::planeWaveRows;
+        kernels.phasorRow = sse2::phasorRow;
+        kernels.waveEquationRow = sse2::waveEquationRow;
+        kernels.integrateRow = sse2::integrateRow;
+        kernels.shallowWaterFluxX = sse2::shallowWaterFluxX;
+        kernels.shallowWaterFluxZ = sse2::shallowWaterFluxZ;
+        kernels.shallowWaterUpdate = sse2::shallowWaterUpdate;
+        kernels.fftButterfly4 = sse2::fftButterfly4;
+        kernels.fftButterfly2 = sse2::fftButterfly2;
+        kernels.oceanSpectrumRow = sse2::oceanSpectrumRow;
+        kernels.expRow = sse2::expRow;
+        kernels.cosRow = sse2::cosRow;
+        break;
+    case WAVE_KERNEL_AVX2:
+        kernels.conicRow = avx2::conicRow;
+        kernels.circularRow = avx2::circularRowKernel(tier);
+        kernels.fusedRow = avx2::fusedRowKernel(tier);
+        kernels.gerstnerRow = avx2::gerstnerRow;
+        kernels.planeWaveRows = avx2::planeWaveRows;
+        kernels.phasorRow = avx2::phasorRow;
+        kernels.waveEquationRow = avx2::waveEquationRow;
+        kernels.integrateRow = avx2::integrateRow;
+        kernels.shallowWaterFluxX = avx2::shallowWaterFluxX;
+        kernels.shallowWaterFluxZ = avx2::shallowWaterFluxZ;
+        kernels.shallowWaterUpdate = avx2::shallowWaterUpdate;
+        kernels.fftButterfly4 = avx2::fftButterfly4;
+        kernels.fftButterfly2 = avx2::fftButterfly2;
+        kernels.oceanSpectrumRow = avx2::oceanSpectrumRow;
+        kernels.expRow = avx2::expRow;
+        kernels.cosRow = avx2::cosRow;
+        break;
+    case WAVE_KERNEL_AVX512:
+        kernels.conicRow = avx512::conicRow;
+        kernels.circularRow = avx512::circularRowKernel(tier);
+        kernels.fusedRow = avx512::fusedRowKernel(tier);
+        kernels.gerstnerRow = avx512::gerstnerRow;
+        kernels.planeWaveRows = avx512::planeWaveRows;
+        kernels.phasorRow = avx512::phasorRow;
+        kernels.waveEquationRow = avx512::waveEquationRow;
+        kernels.integrateRow = avx512::integrateRow;
+        kernels.shallowWaterFluxX = avx512::shallowWaterFluxX;
+        kernels.shallowWaterFluxZ = avx512::shallowWaterFluxZ;
+        kernels.shallowWaterUpdate = avx512::shallowWaterUpdate;
+        kernels.fftButterfly4 = avx512::fftButterfly4;
+        kernels.fftButterfly2 = avx512::fftButterfly2;
+        kernels.oceanSpectrumRow = avx512::oceanSpectrumRow;
+        kernels.expRow = avx512::expRow;
+        kernels.cosRow = avx512::cosRow;
+        break;
+#endif
+    default:
+        kernels.isa = WAVE_KERNEL_SCALAR;
+        kernels.conicRow = scalarConicRow;
+        kernels.circularRow = scalarCircularRow;
+        kernels.fusedRow = scalarFusedRow;
+        kernels.gerstnerRow = scalarGerstnerRow;
+        kernels.planeWaveRows = scalarPlaneWaveRows;
+        kernels.phasorRow = scalarPhasorRow;
+        kernels.waveEquationRow = scalarWaveEquationRow;
+        kernels.integrateRow = scalarIntegrateRow;
+        kernels.shallowWaterFluxX = scalarShallowWaterFluxX;
+        kernels.shallowWaterFluxZ = scalarShallowWaterFluxZ;
+        kernels.shallowWaterUpdate = scalarShallowWaterUpdate;
+        kernels.fftButterfly4 = scalarFftButterfly4;
+        kernels.fftButterfly2 = scalarFftButterfly2;
+        kernels.oceanSpectrumRow = scalarOceanSpectrumRow;
+        kernels.expRow = scalarExpRow;
+        kernels.cosRow = scalarCosRow;
+        break;
+    }
+
+    return kernels;
+}
+
+
+static ColorizeKernels makeColorizeKernels(WaveKernelIsa isa)
+{
+    ColorizeKernels kernels;
+    kernels.isa = isa;
+
+    switch(isa) {
+#ifdef WAVE_KERNELS_SIMD
+    case WAVE_KERNEL_SSE2:
+        kernels.colorizeRow[COLORMAP_SEA] = sse2::colorizeRow<SeaColormap>;
+        kernels.colorizeRow[COLORMAP_DIVERGING] = sse2::colorizeRow<DivergingColormap>;
+        break;
+    case WAVE_KERNEL_AVX2:
+        kernels.colorizeRow[COLORMAP_SEA] = avx2::colorizeRow<SeaColormap>;
+        kernels.colorizeRow[COLORMAP_DIVERGING] = avx2::colorizeRow<DivergingColormap>;
+        break;
+    case WAVE_KERNEL_AVX512:
+        kernels.colorizeRow[COLORMAP_SEA] = avx512::colorizeRow<SeaColormap>;
+        kernels.colorizeRow[COLORMAP_DIVERGING] = avx512::colorizeRow<DivergingColormap>;
+        break;
+#endif
+    default:
+        kernels.isa = WAVE_KERNEL_SCALAR;
+        kernels.colorizeRow[COLORMAP_SEA] = scalarColorizeRow<SeaColormap>;
+        kernels.colorizeRow[COLORMAP_DIVERGING] = scalarColorizeRow<DivergingColormap>;
+        break;
+    }
+
+    return kernels;
+}
+
+
+// Every kernel set, built at the first call (thread safe static initialization) and never modified afterwards
+static const WaveKernels* waveKernelSet(WaveKernelIsa isa, WaveMathTier tier)
+{
+    static const std::vector<WaveKernels> sets = []() {
+        std::vector<WaveKernels> v;
+        for(int i = 0; i < WAVE_KERNEL_ISA_COUNT; i++) {
+            for(int t = 0; t < WAVE_MATH_TIER_COUNT; t++) {
+                v.push_back(makeWaveKernels(WaveKernelIsa(i), WaveMathTier(t)));
+            }
+        }
+        return v;
+    }();
+    return &sets[isa*WAVE_MATH_TIER_COUNT + tier];
+}
+
+// Set in use, NULL until the first call of getWaveKernels or selectWaveKernels
+static void *publishedWaveKernels = NULL;
+
+static const WaveKernels* currentWaveKernels()
+{
+    const WaveKernels *kernels = (const WaveKernels*)SDL_AtomicGetPtr(&publishedWaveKernels);
+    if(kernels == NULL) {
+        // The best ones, unless a selection was published meanwhile
+        SDL_AtomicCASPtr(&publishedWaveKernels, NULL, (void*)waveKernelSet(detectWaveKernelIsa(), WAVE_MATH_TABLE));
+        kernels = (const WaveKernels*)SDL_AtomicGetPtr(&publishedWaveKernels);
+    }
+    return kernels;
+}
+
+
+WaveKernelIsa detectWaveKernelIsa()
+{
+    if(isaSupported(WAVE_KERNEL_AVX512)) {
+        return WAVE_KERNEL_AVX512;
+    }
+    if(isaSupported(WAVE_KERNEL_AVX2)) {
+        return WAVE_KERNEL_AVX2;
+    }
+    if(isaSupported(WAVE_KERNEL_SSE2)) {
+        return WAVE_KERNEL_SSE2;
+    }
+    return WAVE_KERNEL_SCALAR;
+}
+
+
+bool selectWaveKernels(WaveKernelIsa isa)
+{
+    if(!isaSupported(isa)) {
+        return false;
+    }
+    SDL_AtomicSetPtr(&publishedWaveKernels, (void*)waveKernelSet(isa, currentWaveKernels()->tier));
+    return true;
+}
+
+
+void selectWaveMathTier(WaveMathTier tier)
+{
+    SDL_AtomicSetPtr(&publishedWaveKernels, (void*)waveKernelSet(currentWaveKernels()->isa, tier));
+}
+
+
+const WaveKernels& getWaveKernels()
+{
+    return *currentWaveKernels();
+}
+
+
+const ColorizeKernels& getColorizeKernels()
+{
+    static const ColorizeKernels kernels = makeColorizeKernels(detectWaveKernelIsa());
+    return kernels;
+}
+
+
+const char* getWaveKernelIsaName(WaveKernelIsa isa)
+{
+    switch(isa) {
+    case WAVE_KERNEL_SSE2:
+        return "SSE2";
+    case WAVE_KERNEL_AVX2:
+        return "AVX2";
+    case WAVE_KERNEL_AVX512:
+        return "AVX-512";
+    default:
+        return "scalar";
+    }
+}
+
+
+const char* getWaveMathTierName(WaveMathTier tier)
+{
+    switch(tier) {
+    case WAVE_MATH_EXACT:
+        return "exact";
+    case WAVE_MATH_POLYNOMIAL:
+        return "polynomial";
+    default:
+        return "table";
+    }
+}
@@ -0,0 +1,729 @@
+// Vectorized wave kernels, written once for every instruction set
+// No include guard on purpose : wavekernels.cpp includes this file once per instruction set,
+// inside a namespace declaring the Simd class and under the matching "#pragma GCC target"
+//
+// Simd has to provide :
+//   V, Mask, LANES                     vector of LANES floats and the comparison result type
+//   load, store, set1, ramp            ramp() is (0, 1, ..., LANES-1)
+//   add, sub, mul, madd, div, min, max madd(a, b, c) = a*b + c
+//   sqrt, floor, round, pow2n          pow2n(n) = 2^n for integral n
+//   lessEqual, select                  select(m, a, b) = m ? a : b, lane by lane
+//   gather                             gather(base, index) = base[index] for integral non negative index
+//   gatherBits                         same from an array of 32 bits integers, their bits in the float lanes
+
+
+// exp(x) for x in [-87, 88], Cephes expf polynomial : relative error below 2e-7
+static inline Simd::V expApprox(Simd::V x)
+{
+    typedef Simd::V V;
+    x = Simd::select(Simd::lessEqual(x, Simd::set1(-87.0f)), Simd::set1(-87.0f), x);
+    x = Simd::select(Simd::lessEqual(Simd::set1(88.0f), x), Simd::set1(88.0f), x);
+
+    // x = n*ln(2) + r with |r| <= ln(2)/2, ln(2) split in two to keep r exact
+    V n = Simd::round(Simd::mul(x, Simd::set1(1.44269504088896341f)));
+    V r = Simd::madd(n, Simd::set1(-0.693359375f), x);
+    r = Simd::madd(n, Simd::set1(2.12194440e-4f), r);
+
+    V r2 = Simd::mul(r, r);
+    V p = Simd::set1(1.9875691500e-4f);
+    p = Simd::madd(p, r, Simd::set1(1.3981999507e-3f));
+    p = Simd::madd(p, r, Simd::set1(8.3334519073e-3f));
+    p = Simd::madd(p, r, Simd::set1(4.1665795894e-2f));
+    p = Simd::madd(p, r, Simd::set1(1.6666665459e-1f));
+    p = Simd::madd(p, r, Simd::set1(5.0000001201e-1f));
+    p = Simd::madd(p, r2, Simd::add(r, Simd::set1(1.0f)));
+
+    return Simd::mul(p, Simd::pow2n(n));
+}
+
+
+// cos(x), Cephes cosf/sinf polynomials on [-pi/4, pi/4] : absolute error below 1.5e-7 (a float ulp near 1) for
+// |x| < 8192
+static inline Simd::V cosApprox(Simd::V x)
+{
+    typedef Simd::V V;
+    // x = q*pi/2 + r with |r| <= pi/4, pi/2 split in three to keep r exact
+    V q = Simd::round(Simd::mul(x, Simd::set1(0.636619772367581343f)));
+    V r = Simd::madd(q, Simd::set1(-1.5703125f), x);
+    r = Simd::madd(q, Simd::set1(-4.837512969970703125e-4f), r);
+    r = Simd::madd(q, Simd::set1(-7.54978995489188216e-8f), r);
+    V r2 = Simd::mul(r, r);
+
+    V cosR = Simd::set1(2.443315711809948e-5f);
+    cosR = Simd::madd(cosR, r2, Simd::set1(-1.388731625493765e-3f));
+    cosR = Simd::madd(cosR, r2, Simd::set1(4.166664568298827e-2f));
+    cosR = Simd::mul(Simd::mul(cosR, r2), r2);
+    cosR = Simd::madd(r2, Simd::set1(-0.5f), cosR);
+    cosR = Simd::add(cosR, Simd::set1(1.0f));
+
+    V sinR = Simd::set1(-1.9515295891e-4f);
+    sinR = Simd::madd(sinR, r2, Simd::set1(8.3321608736e-3f));
+    sinR = Simd::madd(sinR, r2, Simd::set1(-1.6666654611e-1f));
+    sinR = Simd::madd(Simd::mul(sinR, r2), r, r);
+
+    // Quadrant q mod 4 : cos(r), -sin(r), -cos(r), sin(r)
+    // Computed with floats only, so that every instruction set shares the same code
+    V q4 = Simd::sub(q, Simd::mul(Simd::set1(4.0f), Simd::floor(Simd::mul(q, Simd::set1(0.25f)))));
+    V impair = Simd::sub(q4, Simd::mul(Simd::set1(2.0f), Simd::floor(Simd::mul(q4, Simd::set1(0.5f)))));
+    V q4p1 = Simd::add(q4, Simd::set1(1.0f));
+    V negatif = Simd::sub(Simd::floor(Simd::mul(q4p1, Simd::set1(0.5f))),
+                          Simd::mul(Simd::set1(2.0f), Simd::floor(Simd::mul(q4p1, Simd::set1(0.25f)))));
+
+    V res = Simd::madd(impair, Simd::sub(sinR, cosR), cosR);
+    return Simd::mul(res, Simd::madd(negatif, Simd::set1(-2.0f), Simd::set1(1.0f)));
+}
+
+
+// Contribution of a ConicWave to LANES points at dx from the origin, dz2 = dz^2
+static inline Simd::V conicContribution(Simd::V dx, Simd::V dz2, const ConicKernelParams &params)
+{
+    typedef Simd::V V;
+    V distance = Simd::sqrt(Simd::madd(dx, dx, dz2));
+    V cone = Simd::madd(Simd::set1(-params.pente), distance, Simd::set1(params.height));
+    return Simd::select(Simd::lessEqual(distance, Simd::set1(params.radius)), cone, Simd::set1(0.0f));
+}
+
+
+// Contribution of a CircularWave to LANES points
+static inline Simd::V circularContribution(Simd::V dx, Simd::V dz2, const CircularKernelParams &params)
+{
+    typedef Simd::V V;
+    V distance = Simd::sqrt(Simd::madd(dx, dx, dz2));
+    V enveloppe = Simd::mul(Simd::set1(params.height), expApprox(Simd::mul(Simd::set1(params.amortissement), distance)));
+    V onde = cosApprox(Simd::mul(Simd::set1(params.pulsation), Simd::sub(distance, Simd::set1(params.radius))));
+    return Simd::select(Simd::lessEqual(distance, Simd::set1(params.reach)), Simd::mul(enveloppe, onde), Simd::set1(0.0f));
+}
+
+
+// Same with libm, lane by lane : the exact tier
+static inline Simd::V circularExactContribution(Simd::V dx, Simd::V dz2, const CircularKernelParams &params)
+{
+    float distances[Simd::LANES], h[Simd::LANES];
+    Simd::store(distances, Simd::sqrt(Simd::madd(dx, dx, dz2)));
+    for(int l = 0; l < Simd::LANES; l++) {
+        h[l] = 0;
+        if(distances[l] <= params.reach) {
+            h[l] = params.height*exp(params.amortissement*distances[l])*cos(params.pulsation*(distances[l] - params.radius));
+        }
+    }
+    return Simd::load(h);
+}
+
+
+// Same from the radial profile of the batch : linear interpolation of the two samples around the distance
+static inline Simd::V circularProfileContribution(Simd::V dx, Simd::V dz2, const float *profile,
+                                                  const CircularKernelParams &params)
+{
+    typedef Simd::V V;
+    V distance = Simd::sqrt(Simd::madd(dx, dx, dz2));
+    V position = Simd::mul(distance, Simd::set1(params.profileScale));
+    // Points beyond the reach read the last interval, their contribution is dropped anyway
+    V indice = Simd::min(Simd::floor(position), Simd::set1(float(params.nbProfileSamples - 2)));
+    V avant = Simd::gather(profile, indice);
+    V apres = Simd::gather(profile + 1, indice);
+    V h = Simd::madd(Simd::sub(position, indice), Simd::sub(apres, avant), avant);
+    return Simd::select(Simd::lessEqual(distance, Simd::set1(params.reach)), h, Simd::set1(0.0f));
+}
+
+
+static void conicRow(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                     const ConicKernelParams &params)
+{
+    typedef Simd::V V;
+    const V dz = Simd::set1(float(z - params.originZ));
+    const V dz2 = Simd::mul(dz, dz);
+    const V pas = Simd::set1(float(step));
+    const V dx0 = Simd::set1(float(x0 - params.originX));
+
+    int colonne = debut;
+    for(; colonne + Simd::LANES <= fin; colonne += Simd::LANES) {
+        V dx = Simd::madd(Simd::add(Simd::set1(float(colonne)), Simd::ramp()), pas, dx0);
+        V h = Simd::load(hauteurs + colonne);
+        Simd::store(hauteurs + colonne, Simd::add(h, conicContribution(dx, dz2, params)));
+    }
+
+    // Remaining points with the scalar reference
+    if(colonne < fin) {
+        scalarConicRow(hauteurs, colonne, fin, x0, step, z, params);
+    }
+}
+
+
+template<int TIER>
+static void circularRow(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                        const CircularKernelParams &params)
+{
+    typedef Simd::V V;
+    const V dz = Simd::set1(float(z - params.originZ));
+    const V dz2 = Simd::mul(dz, dz);
+    const V pas = Simd::set1(float(step));
+    const V dx0 = Simd::set1(float(x0 - params.originX));
+
+    int colonne = debut;
+    for(; colonne + Simd::LANES <= fin; colonne += Simd::LANES) {
+        V dx = Simd::madd(Simd::add(Simd::set1(float(colonne)), Simd::ramp()), pas, dx0);
+        V h = Simd::load(hauteurs + colonne);
+        if(TIER == WAVE_MATH_EXACT) {
+            Simd::store(hauteurs + colonne, Simd::add(h, circularExactContribution(dx, dz2, params)));
+        }
+        else {
+            Simd::store(hauteurs + colonne, Simd::add(h, circularContribution(dx, dz2, params)));
+        }
+    }
+
+    // Remaining points with the scalar reference
+    if(colonne < fin) {
+        scalarCircularRow(hauteurs, colonne, fin, x0, step, z, params);
+    }
+}
+
+
+template<int TIER>
+static void fusedRow(GLfloat *hauteurs, int debut, int fin, double x0, double step, double z,
+                     const WaveBatch &batch)
+{
+    typedef Simd::V V;
+    const V pas = Simd::set1(float(step));
+    FusedWave actives[FUSED_GROUP_SIZE];
+    int nbWaves = batch.conics.size() + batch.circulars.size();
+
+    // Only the waves crossing the row fill the group : with up to FUSED_GROUP_SIZE of them, each vector of the row is
+    // loaded once, summed in a register with every wave and stored once
+    int w = 0;
+    while(w < nbWaves) {
+        int nbActives = 0;
+        int actifDebut = fin, actifFin = debut;
+        for(; w < nbWaves && nbActives < FUSED_GROUP_SIZE; w++) {
+            if(fusedWaveSpan(batch, w, debut, fin, x0, step, z, &actives[nbActives])) {
+                actifDebut = std::min(actifDebut, actives[nbActives].debut);
+                actifFin = std::max(actifFin, actives[nbActives].fin);
+                nbActives++;
+            }
+        }
+
+        int colonne = actifDebut;
+        for(; colonne + Simd::LANES <= actifFin; colonne += Simd::LANES) {
+            V x = Simd::madd(Simd::add(Simd::set1(float(colonne)), Simd::ramp()), pas, Simd::set1(float(x0)));
+            V h = Simd::load(hauteurs + colonne);
+            for(int a = 0; a < nbActives; a++) {
+                const FusedWave &active = actives[a];
+                if(colonne + Simd::LANES <= active.debut || colonne >= active.fin) {
+                    continue;
+                }
+                V dx = Simd::sub(x, Simd::set1(active.originX));
+                V dz2 = Simd::set1(active.dz2);
+                if(active.conic != NULL) {
+                    h = Simd::add(h, conicContribution(dx, dz2, *active.conic));
+                }
+                else if(TIER == WAVE_MATH_TABLE && active.profile != NULL) {
+                    h = Simd::add(h, circularProfileContribution(dx, dz2, active.profile, *active.circular));
+                }
+                else if(TIER == WAVE_MATH_EXACT) {
+                    h = Simd::add(h, circularExactContribution(dx, dz2, *active.circular));
+                }
+                else {
+                    h = Simd::add(h, circularContribution(dx, dz2, *active.circular));
+                }
+            }
+            Simd::store(hauteurs + colonne, h);
+        }
+
+        // Remaining points with the scalar reference
+        if(colonne < actifFin) {
+            scalarFusedTail(hauteurs, colonne, x0, step, z, actives, nbActives);
+        }
+    }
+}
+
+
+static void waveEquationRow(GLfloat *speeds, GLfloat *accelerations, const GLfloat *hauteurs,
+                            const GLfloat *dessus, const GLfloat *dessous, const GLfloat *sources,
+                            int nbPoints, const WaveEquationParams &params)
+{
+    typedef Simd::V V;
+    const V c2SurDx2 = Simd::set1(params.c2SurDx2);
+    const V moinsAmortissement = Simd::set1(-params.damping);
+    const V gain = Simd::set1(params.sourceGain);
+    const V dt = Simd::set1(params.dt);
+    const V moinsCentre = Simd::set1(-params.centre);
+
+    // First and last columns need the reflecting border
+    int fin = nbPoints - 1;
+    scalarWaveEquationSpan(speeds, accelerations, hauteurs, dessus, dessous, sources, 0, 1, nbPoints, params);
+
+    int colonne = 1;
+    for(; colonne + Simd::LANES <= fin; colonne += Simd::LANES) {
+        V h = Simd::load(hauteurs + colonne);
+        V voisins = Simd::add(Simd::add(Simd::load(hauteurs + colonne - 1), Simd::load(hauteurs + colonne + 1)),
+                              Simd::add(Simd::load(dessus + colonne), Simd::load(dessous + colonne)));
+        V v = Simd::load(speeds + colonne);
+        V a = Simd::madd(c2SurDx2, voisins, Simd::madd(moinsCentre, h, Simd::mul(moinsAmortissement, v)));
+        if(sources != NULL) {
+            a = Simd::madd(gain, Simd::load(sources + colonne), a);
+        }
+        Simd::store(accelerations + colonne, a);
+        Simd::store(speeds + colonne, Simd::madd(a, dt, v));
+    }
+
+    if(colonne < nbPoints) {
+        scalarWaveEquationSpan(speeds, accelerations, hauteurs, dessus, dessous, sources, colonne, nbPoints, nbPoints, params);
+    }
+}
+
+
+static void integrateRow(GLfloat *hauteurs, const GLfloat *speeds, int nbPoints, float dt)
+{
+    const Simd::V pas = Simd::set1(dt);
+
+    int colonne = 0;
+    for(; colonne + Simd::LANES <= nbPoints; colonne += Simd::LANES) {
+        Simd::store(hauteurs + colonne, Simd::madd(Simd::load(speeds + colonne), pas, Simd::load(hauteurs + colonne)));
+    }
+    if(colonne < nbPoints) {
+        scalarIntegrateRow(hauteurs + colonne, speeds + colonne, nbPoints - colonne, dt);
+    }
+}
+
+
+// Velocity q/h of the wet lanes, 0 on the dry ones
+static inline Simd::V shallowWaterVelocity(Simd::V q, Simd::V h, Simd::V dry)
+{
+    return Simd::select(Simd::lessEqual(h, dry), Simd::set1(0.0f), Simd::div(q, Simd::max(h, dry)));
+}
+
+
+static inline Simd::V absolute(Simd::V a)
+{
+    return Simd::max(a, Simd::sub(Simd::set1(0.0f), a));
+}
+
+
+// Same as scalarShallowWaterFace, for LANES faces stored from flux[i]
+static inline void shallowWaterFace(Simd::V hL, Simd::V qnL, Simd::V qtL, Simd::V bL,
+                                    Simd::V hR, Simd::V qnR, Simd::V qtR, Simd::V bR,
+                                    const ShallowWaterParams &params, const ShallowWaterFluxes &flux, int i)
+{
+    typedef Simd::V V;
+    const V zero = Simd::set1(0.0f);
+    const V demi = Simd::set1(0.5f);
+    const V g = Simd::set1(params.gravity);
+    const V dry = Simd::set1(params.dry);
+
+    V fond = Simd::max(bL, bR);
+    V hEtoileL = Simd::max(zero, Simd::sub(Simd::add(hL, bL), fond));
+    V hEtoileR = Simd::max(zero, Simd::sub(Simd::add(hR, bR), fond));
+    V uL = shallowWaterVelocity(qnL, hL, dry), vL = shallowWaterVelocity(qtL, hL, dry);
+    V uR = shallowWaterVelocity(qnR, hR, dry), vR = shallowWaterVelocity(qtR, hR, dry);
+    V a = Simd::max(Simd::add(absolute(uL), Simd::sqrt(Simd::mul(g, hEtoileL))),
+                    Simd::add(absolute(uR), Simd::sqrt(Simd::mul(g, hEtoileR))));
+    V demiA = Simd::mul(demi, a);
+    V demiG = Simd::mul(demi, g);
+
+    V qL = Simd::mul(hEtoileL, uL), qR = Simd::mul(hEtoileR, uR);
+    V pressionL = Simd::mul(demiG, Simd::mul(hEtoileL, hEtoileL));
+    V pressionR = Simd::mul(demiG, Simd::mul(hEtoileR, hEtoileR));
+    V normal = Simd::add(Simd::madd(qL, uL, pressionL), Simd::madd(qR, uR, pressionR));
+    normal = Simd::sub(Simd::mul(demi, normal), Simd::mul(demiA, Simd::sub(qR, qL)));
+    V masse = Simd::sub(Simd::mul(demi, Simd::add(qL, qR)), Simd::mul(demiA, Simd::sub(hEtoileR, hEtoileL)));
+    V tangente = Simd::mul(demi, Simd::madd(qL, vL, Simd::mul(qR, vR)));
+    tangente = Simd::sub(tangente, Simd::mul(demiA, Simd::sub(Simd::mul(hEtoileR, vR), Simd::mul(hEtoileL, vL))));
+
+    Simd::store(flux.masse + i, masse);
+    Simd::store(flux.normalGauche + i, Simd::sub(Simd::madd(demiG, Simd::mul(hL, hL), normal), pressionL));
+    Simd::store(flux.normalDroite + i, Simd::sub(Simd::madd(demiG, Simd::mul(hR, hR), normal), pressionR));
+    Simd::store(flux.tangente + i, tangente);
+}
+
+
+static void shallowWaterFluxX(const ShallowWaterRow &ligne, int debut, int fin, int nbPoints,
+                              const ShallowWaterParams &params, const ShallowWaterFluxes &flux)
+{
+    // Faces on the walls with the scalar reference, both neighbours of the other ones are in the line
+    int face = std::max(debut, 1);
+    int faceFin = std::min(fin+1, nbPoints);
+    scalarShallowWaterFluxXSpan(ligne, debut, debut, face, nbPoints, params, flux);
+
+    for(; face + Simd::LANES <= faceFin; face += Simd::LANES) {
+        shallowWaterFace(Simd::load(ligne.depth + face-1), Simd::load(ligne.momentumX + face-1),
+                         Simd::load(ligne.momentumZ + face-1), Simd::load(ligne.bed + face-1),
+                         Simd::load(ligne.depth + face), Simd::load(ligne.momentumX + face),
+                         Simd::load(ligne.momentumZ + face), Simd::load(ligne.bed + face),
+                         params, flux, face - debut);
+    }
+
+    scalarShallowWaterFluxXSpan(ligne, debut, face, fin+1, nbPoints, params, flux);
+}
+
+
+static void shallowWaterFluxZ(const ShallowWaterRow &haut, const ShallowWaterRow &bas, float signeHaut,
+                              float signeBas, int debut, int fin, const ShallowWaterParams &params,
+                              const ShallowWaterFluxes &flux)
+{
+    const Simd::V sHaut = Simd::set1(signeHaut);
+    const Simd::V sBas = Simd::set1(signeBas);
+
+    int colonne = debut;
+    for(; colonne + Simd::LANES <= fin; colonne += Simd::LANES) {
+        shallowWaterFace(Simd::load(haut.depth + colonne), Simd::mul(sHaut, Simd::load(haut.momentumZ + colonne)),
+                         Simd::load(haut.momentumX + colonne), Simd::load(haut.bed + colonne),
+                         Simd::load(bas.depth + colonne), Simd::mul(sBas, Simd::load(bas.momentumZ + colonne)),
+                         Simd::load(bas.momentumX + colonne), Simd::load(bas.bed + colonne),
+                         params, flux, colonne - debut);
+    }
+
+    if(colonne < fin) {
+        scalarShallowWaterFluxZSpan(haut, bas, signeHaut, signeBas, debut, colonne, fin, params, flux);
+    }
+}
+
+
+static float shallowWaterUpdate(const ShallowWaterRow &ancien, GLfloat *depth, GLfloat *momentumX,
+                                GLfloat *momentumZ, const ShallowWaterFluxes &x, const ShallowWaterFluxes &haut,
+                                const ShallowWaterFluxes &bas, int debut, int fin, const ShallowWaterParams &params)
+{
+    typedef Simd::V V;
+    const V zero = Simd::set1(0.0f);
+    const V dry = Simd::set1(params.dry);
+    const V g = Simd::set1(params.gravity);
+    const V moinsDtSurDx = Simd::set1(-params.dtSurDx);
+    V vitesseMax = zero;
+
+    int colonne = debut;
+    for(; colonne + Simd::LANES <= fin; colonne += Simd::LANES) {
+        int i = colonne - debut;
+        V divMasse = Simd::add(Simd::sub(Simd::load(x.masse + i+1), Simd::load(x.masse + i)),
+                               Simd::sub(Simd::load(bas.masse + i), Simd::load(haut.masse + i)));
+        V divX = Simd::add(Simd::sub(Simd::load(x.normalGauche + i+1), Simd::load(x.normalDroite + i)),
+                           Simd::sub(Simd::load(bas.tangente + i), Simd::load(haut.tangente + i)));
+        V divZ = Simd::add(Simd::sub(Simd::load(x.tangente + i+1), Simd::load(x.tangente + i)),
+                           Simd::sub(Simd::load(bas.normalGauche + i), Simd::load(haut.normalDroite + i)));
+        V h = Simd::madd(moinsDtSurDx, divMasse, Simd::load(ancien.depth + colonne));
+        V qx = Simd::madd(moinsDtSurDx, divX, Simd::load(ancien.momentumX + colonne));
+        V qz = Simd::madd(moinsDtSurDx, divZ, Simd::load(ancien.momentumZ + colonne));
+
+        // Drying cells : the water left stays still
+        Simd::Mask sec = Simd::lessEqual(h, dry);
+        h = Simd::max(h, zero);
+        qx = Simd::select(sec, zero, qx);
+        qz = Simd::select(sec, zero, qz);
+        Simd::store(depth + colonne, h);
+        Simd::store(momentumX + colonne, qx);
+        Simd::store(momentumZ + colonne, qz);
+
+        V vitesse = Simd::div(Simd::max(absolute(qx), absolute(qz)), Simd::max(h, dry));
+        vitesse = Simd::add(vitesse, Simd::sqrt(Simd::mul(g, h)));
+        vitesseMax = Simd::max(vitesseMax, Simd::select(sec, zero, vitesse));
+    }
+
+    float lanes[Simd::LANES];
+    Simd::store(lanes, vitesseMax);
+    float resultat = 0;
+    for(int l = 0; l < Simd::LANES; l++) {
+        resultat = std::max(resultat, lanes[l]);
+    }
+    if(colonne < fin) {
+        resultat = std::max(resultat, scalarShallowWaterUpdateSpan(ancien, depth, momentumX, momentumZ, x, haut, bas,
+                                                                  debut, colonne, fin, params));
+    }
+    return resultat;
+}
+
+
+static void fftButterfly4(const FftButterfly &b, int debut, int fin)
+{
+    typedef Simd::V V;
+    const V sens = Simd::set1(b.sens);
+    const V w1R = Simd::set1(b.reW[0]), w1I = Simd::set1(b.imW[0]);
+    const V w2R = Simd::set1(b.reW[1]), w2I = Simd::set1(b.imW[1]);
+    const V w3R = Simd::set1(b.reW[2]), w3I = Simd::set1(b.imW[2]);
+
+    int c = debut;
+    for(; c + Simd::LANES <= fin; c += Simd::LANES) {
+        V aR = Simd::load(b.reEntree[0] + c), aI = Simd::load(b.imEntree[0] + c);
+        V bR = Simd::load(b.reEntree[1] + c), bI = Simd::load(b.imEntree[1] + c);
+        V cR = Simd::load(b.reEntree[2] + c), cI = Simd::load(b.imEntree[2] + c);
+        V dR = Simd::load(b.reEntree[3] + c), dI = Simd::load(b.imEntree[3] + c);
+
+        V apcR = Simd::add(aR, cR), apcI = Simd::add(aI, cI);
+        V amcR = Simd::sub(aR, cR), amcI = Simd::sub(aI, cI);
+        V bpdR = Simd::add(bR, dR), bpdI = Simd::add(bI, dI);
+        V jR = Simd::mul(sens, Simd::sub(dI, bI));
+        V jI = Simd::mul(sens, Simd::sub(bR, dR));
+
+        V t1R = Simd::add(amcR, jR), t1I = Simd::add(amcI, jI);
+        V t2R = Simd::sub(apcR, bpdR), t2I = Simd::sub(apcI, bpdI);
+        V t3R = Simd::sub(amcR, jR), t3I = Simd::sub(amcI, jI);
+        Simd::store(b.reSortie[0] + c, Simd::add(apcR, bpdR));
+        Simd::store(b.imSortie[0] + c, Simd::add(apcI, bpdI));
+        Simd::store(b.reSortie[1] + c, Simd::sub(Simd::mul(w1R, t1R), Simd::mul(w1I, t1I)));
+        Simd::store(b.imSortie[1] + c, Simd::madd(w1R, t1I, Simd::mul(w1I, t1R)));
+        Simd::store(b.reSortie[2] + c, Simd::sub(Simd::mul(w2R, t2R), Simd::mul(w2I, t2I)));
+        Simd::store(b.imSortie[2] + c, Simd::madd(w2R, t2I, Simd::mul(w2I, t2R)));
+        Simd::store(b.reSortie[3] + c, Simd::sub(Simd::mul(w3R, t3R), Simd::mul(w3I, t3I)));
+        Simd::store(b.imSortie[3] + c, Simd::madd(w3R, t3I, Simd::mul(w3I, t3R)));
+    }
+
+    if(c < fin) {
+        scalarFftButterfly4Span(b, c, fin);
+    }
+}
+
+
+static void fftButterfly2(const FftButterfly &b, int debut, int fin)
+{
+    typedef Simd::V V;
+    int c = debut;
+    for(; c + Simd::LANES <= fin; c += Simd::LANES) {
+        V aR = Simd::load(b.reEntree[0] + c), aI = Simd::load(b.imEntree[0] + c);
+        V bR = Simd::load(b.reEntree[1] + c), bI = Simd::load(b.imEntree[1] + c);
+        Simd::store(b.reSortie[0] + c, Simd::add(aR, bR));
+        Simd::store(b.imSortie[0] + c, Simd::add(aI, bI));
+        Simd::store(b.reSortie[1] + c, Simd::sub(aR, bR));
+        Simd::store(b.imSortie[1] + c, Simd::sub(aI, bI));
+    }
+
+    if(c < fin) {
+        scalarFftButterfly2(b, c, fin);
+    }
+}
+
+
+static void oceanSpectrumRow(const OceanSpectrumRow &row, int nbPoints, float dt)
+{
+    typedef Simd::V V;
+    const V pas = Simd::set1(dt);
+    const V deuxPi = Simd::set1(6.28318530717958648f);
+    const V unSurDeuxPi = Simd::set1(0.159154943091895336f);
+    const V demiPi = Simd::set1(1.57079632679489662f);
+
+    int k = 0;
+    for(; k + Simd::LANES <= nbPoints; k += Simd::LANES) {
+        V omega = Simd::load(row.omega + k);
+        V phase = Simd::madd(omega, pas, Simd::load(row.phase + k));
+        phase = Simd::madd(Simd::floor(Simd::mul(phase, unSurDeuxPi)), Simd::sub(Simd::set1(0.0f), deuxPi), phase);
+        Simd::store(row.phase + k, phase);
+
+        // The phase stays small : cosApprox is accurate, sin(x) = cos(x - pi/2)
+        V c = cosApprox(phase), s = cosApprox(Simd::sub(phase, demiPi));
+        V h0R = Simd::load(row.reH0 + k), h0I = Simd::load(row.imH0 + k);
+        V gR = Simd::load(row.reH0Conj + k), gI = Simd::load(row.imH0Conj + k);
+        V aR = Simd::sub(Simd::mul(h0R, c), Simd::mul(h0I, s));
+        V aI = Simd::madd(h0R, s, Simd::mul(h0I, c));
+        V bR = Simd::madd(gR, c, Simd::mul(gI, s));
+        V bI = Simd::sub(Simd::mul(gI, c), Simd::mul(gR, s));
+
+        // h + i*dh/dt = (a + b) - omega (a - b)
+        Simd::store(row.reSortie + k, Simd::sub(Simd::add(aR, bR), Simd::mul(omega, Simd::sub(aR, bR))));
+        Simd::store(row.imSortie + k, Simd::sub(Simd::add(aI, bI), Simd::mul(omega, Simd::sub(aI, bI))));
+    }
+
+    if(k < nbPoints) {
+        scalarOceanSpectrumSpan(row, k, nbPoints, dt);
+    }
+}
+
+
+static void gerstnerRow(GLfloat *hauteurs, GLfloat *deplacementsX, GLfloat *deplacementsZ, int debut, int fin,
+                        double x0, double step, double z, const GerstnerKernelParams *components,
+                        int nbComponents)
+{
+    typedef Simd::V V;
+    V cosTheta[GERSTNER_GROUP_SIZE], sinTheta[GERSTNER_GROUP_SIZE];
+    V cosPas[GERSTNER_GROUP_SIZE], sinPas[GERSTNER_GROUP_SIZE];
+    float cosLanes[Simd::LANES], sinLanes[Simd::LANES];
+
+    int vecteursFin = debut + (fin - debut) / Simd::LANES * Simd::LANES;
+    for(int tuile = debut; tuile < vecteursFin; tuile += GERSTNER_TILE_COLUMNS) {
+        int tuileFin = std::min(tuile + GERSTNER_TILE_COLUMNS, vecteursFin);
+
+        for(int premiere = 0; premiere < nbComponents; premiere += GERSTNER_GROUP_SIZE) {
+            int nbGroupe = std::min(GERSTNER_GROUP_SIZE, nbComponents - premiere);
+            const GerstnerKernelParams *groupe = components + premiere;
+
+            // e^(i theta) of the first LANES points of the tile and the rotation from a vector to the next one,
+            // exact at the start of every tile so that the rounding errors do not pile up along the row
+            for(int g = 0; g < nbGroupe; g++) {
+                double theta = groupe[g].kx*(x0 + tuile*step) + groupe[g].kz*z;
+                double delta = groupe[g].kx*step;
+                double c = cos(theta), s = sin(theta), cosDelta = cos(delta), sinDelta = sin(delta);
+                double cosPasLanes = 1, sinPasLanes = 0;
+                for(int l = 0; l < Simd::LANES; l++) {
+                    cosLanes[l] = c;
+                    sinLanes[l] = s;
+                    double t = c*cosDelta - s*sinDelta;
+                    s = s*cosDelta + c*sinDelta;
+                    c = t;
+                    t = cosPasLanes*cosDelta - sinPasLanes*sinDelta;
+                    sinPasLanes = sinPasLanes*cosDelta + cosPasLanes*sinDelta;
+                    cosPasLanes = t;
+                }
+                cosTheta[g] = Simd::load(cosLanes);
+                sinTheta[g] = Simd::load(sinLanes);
+                cosPas[g] = Simd::set1(cosPasLanes);
+                sinPas[g] = Simd::set1(sinPasLanes);
+            }
+
+            for(int colonne = tuile; colonne < tuileFin; colonne += Simd::LANES) {
+                V h = Simd::load(hauteurs + colonne);
+                V dx = Simd::set1(0.0f), dz = Simd::set1(0.0f);
+                for(int g = 0; g < nbGroupe; g++) {
+                    const GerstnerKernelParams &p = groupe[g];
+                    V c = cosTheta[g], s = sinTheta[g];
+                    h = Simd::madd(Simd::set1(p.reVertical), s, Simd::madd(Simd::set1(p.imVertical), c, h));
+                    if(deplacementsX != NULL) {
+                        dx = Simd::madd(Simd::set1(p.reHorizontalX), c, Simd::madd(Simd::set1(-p.imHorizontalX), s, dx));
+                        dz = Simd::madd(Simd::set1(p.reHorizontalZ), c, Simd::madd(Simd::set1(-p.imHorizontalZ), s, dz));
+                    }
+                    cosTheta[g] = Simd::sub(Simd::mul(c, cosPas[g]), Simd::mul(s, sinPas[g]));
+                    sinTheta[g] = Simd::madd(s, cosPas[g], Simd::mul(c, sinPas[g]));
+                }
+                Simd::store(hauteurs + colonne, h);
+                if(deplacementsX != NULL) {
+                    Simd::store(deplacementsX + colonne, Simd::add(Simd::load(deplacementsX + colonne), dx));
+                    Simd::store(deplacementsZ + colonne, Simd::add(Simd::load(deplacementsZ + colonne), dz));
+                }
+            }
+        }
+    }
+
+    // Remaining points with the scalar reference
+    if(vecteursFin < fin) {
+        scalarGerstnerRow(hauteurs, deplacementsX, deplacementsZ, vecteursFin, fin, x0, step, z, components, nbComponents);
+    }
+}
+
+
+// NB_LIGNES lines of the plane waves : for every vector of columns, the table entries of a wave are loaded once
+// and used by all the lines, whose sums stay in registers
+template <int NB_LIGNES>
+static inline void planeWaveLines(GLfloat *hauteurs, int rowStride, int ligne, int vecteursFin,
+                                  const PlaneWaveTables &tables)
+{
+    typedef Simd::V V;
+    int nbComponents = tables.nbComponents;
+    const float *coefCos = &tables.coefCos[ligne*nbComponents];
+    const float *coefSin = &tables.coefSin[ligne*nbComponents];
+
+    for(int colonne = 0; colonne < vecteursFin; colonne += Simd::LANES) {
+        V h[NB_LIGNES];
+        for(int l = 0; l < NB_LIGNES; l++) {
+            h[l] = Simd::load(hauteurs + (ligne + l)*rowStride + colonne);
+        }
+        const float *cosX = &tables.cosX[colonne], *sinX = &tables.sinX[colonne];
+        for(int k = 0; k < nbComponents; k++) {
+            V c = Simd::load(cosX + k*tables.nbColonnes);
+            V s = Simd::load(sinX + k*tables.nbColonnes);
+            for(int l = 0; l < NB_LIGNES; l++) {
+                h[l] = Simd::madd(Simd::set1(coefCos[l*nbComponents + k]), c,
+                                  Simd::madd(Simd::set1(coefSin[l*nbComponents + k]), s, h[l]));
+            }
+        }
+        for(int l = 0; l < NB_LIGNES; l++) {
+            Simd::store(hauteurs + (ligne + l)*rowStride + colonne, h[l]);
+        }
+    }
+}
+
+static void planeWaveRows(GLfloat *hauteurs, int rowStride, int ligneDebut, int ligneFin,
+                          const PlaneWaveTables &tables)
+{
+    int vecteursFin = tables.nbColonnes / Simd::LANES * Simd::LANES;
+    int ligne = ligneDebut;
+    for(; ligne + PLANE_WAVE_LINES <= ligneFin; ligne += PLANE_WAVE_LINES) {
+        planeWaveLines<PLANE_WAVE_LINES>(hauteurs, rowStride, ligne, vecteursFin, tables);
+    }
+    for(; ligne < ligneFin; ligne++) {
+        planeWaveLines<1>(hauteurs, rowStride, ligne, vecteursFin, tables);
+    }
+
+    // Remaining columns with the scalar reference
+    if(vecteursFin < tables.nbColonnes) {
+        scalarPlaneWaveSpan(hauteurs, rowStride, ligneDebut, ligneFin, vecteursFin, tables.nbColonnes, tables);
+    }
+}
+
+
+static void phasorRow(GLfloat *hauteurs, const GLfloat *re, const GLfloat *im, int nbPoints,
+                      float cosTheta, float sinTheta)
+{
+    const Simd::V c = Simd::set1(cosTheta), s = Simd::set1(sinTheta);
+
+    int colonne = 0;
+    for(; colonne + Simd::LANES <= nbPoints; colonne += Simd::LANES) {
+        Simd::V h = Simd::madd(Simd::load(re + colonne), c, Simd::load(hauteurs + colonne));
+        Simd::store(hauteurs + colonne, Simd::madd(Simd::load(im + colonne), s, h));
+    }
+    if(colonne < nbPoints) {
+        scalarPhasorRow(hauteurs + colonne, re + colonne, im + colonne, nbPoints - colonne, cosTheta, sinTheta);
+    }
+}
+
+
+static void expRow(const GLfloat *x, GLfloat *y, int nbPoints)
+{
+    int i = 0;
+    for(; i + Simd::LANES <= nbPoints; i += Simd::LANES) {
+        Simd::store(y + i, expApprox(Simd::load(x + i)));
+    }
+    if(i < nbPoints) {
+        scalarExpRow(x + i, y + i, nbPoints - i);
+    }
+}
+
+static void cosRow(const GLfloat *x, GLfloat *y, int nbPoints)
+{
+    int i = 0;
+    for(; i + Simd::LANES <= nbPoints; i += Simd::LANES) {
+        Simd::store(y + i, cosApprox(Simd::load(x + i)));
+    }
+    if(i < nbPoints) {
+        scalarCosRow(x + i, y + i, nbPoints - i);
+    }
+}
+
+
+// Instances of the kernels depending on the approximation tier
+static CircularRowKernel circularRowKernel(WaveMathTier tier)
+{
+    // Without the batch there is no table : the polynomials
+    return tier == WAVE_MATH_EXACT ? circularRow<WAVE_MATH_EXACT> : circularRow<WAVE_MATH_POLYNOMIAL>;
+}
+
+static FusedRowKernel fusedRowKernel(WaveMathTier tier)
+{
+    switch(tier) {
+    case WAVE_MATH_EXACT:
+        return fusedRow<WAVE_MATH_EXACT>;
+    case WAVE_MATH_POLYNOMIAL:
+        return fusedRow<WAVE_MATH_POLYNOMIAL>;
+    default:
+        return fusedRow<WAVE_MATH_TABLE>;
+    }
+}
+
+
+// Table of the colormap at the nearest height : one multiply-add, two clamps and a gather per vector
+template<class Colormap>
+static void colorizeRow(const GLfloat *hauteurs, GLuint *couleurs, int nbPoints)
+{
+    const float echelle = (COLORMAP_SIZE - 1) / (COLORMAP_MAX_HEIGHT - COLORMAP_MIN_HEIGHT);
+    const Simd::V pente = Simd::set1(echelle);
+    const Simd::V decalage = Simd::set1(-COLORMAP_MIN_HEIGHT*echelle);
+    const Simd::V zero = Simd::set1(0.0f);
+    const Simd::V dernier = Simd::set1(COLORMAP_SIZE - 1);
+    const Simd::V demi = Simd::set1(0.5f);
+
+    if(nbPoints < Simd::LANES) {
+        tableColorizeRow<Colormap>(hauteurs, couleurs, nbPoints);
+        return;
+    }
+    for(int colonne = 0; colonne < nbPoints; colonne += Simd::LANES) {
+        // The last vector ends on the last point, over colors already written : same heights, same colors
+        int debut = std::min(colonne, nbPoints - Simd::LANES);
+        // max first : a NaN height gives the first color
+        Simd::V index = Simd::madd(Simd::load(hauteurs + debut), pente, decalage);
+        index = Simd::min(Simd::max(index, zero), dernier);
+        Simd::V couleur = Simd::gatherBits(colormapTable<Colormap>.couleurs, Simd::add(index, demi));
+        Simd::store((float*)(couleurs + debut), couleur);
+    }
+}
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include "waveregistry.h"
+
+
+/***************************************************************************/
+/* ConicWave table                                                         */
+/***************************************************************************/
+void ConicWaveColumns::push(const ConicWave &wave)
+{
+    originX.push_back(wave.getWaveOrigin().x);
+    originZ.push_back(wave.getWaveOrigin().z);
+    speedX.push_back(wave.getWaveSpeed().x);
+    speedZ.push_back(wave.getWaveSpeed().z);
+    accelerationX.push_back(wave.getWaveAcceleration().x);
+    accelerationZ.push_back(wave.getWaveAcceleration().z);
+    height.push_back(wave.getWaveHeight());
+    radius.push_back(wave.getWaveRadius());
+}
+
+
+ConicWave ConicWaveColumns::getAt(int index) const
+{
+    return ConicWave(Point(originX[index], 0, originZ[index]), height[index], radius[index],
+                     Vector(speedX[index], 0, speedZ[index]),
+                     Vector(accelerationX[index], 0, accelerationZ[index]));
+}
+
+
+void ConicWaveColumns::setAt(int index, const ConicWave &wave)
+{
+    originX[index] = wave.getWaveOrigin().x;
+    originZ[index] = wave.getWaveOrigin().z;
+    speedX[index] = wave.getWaveSpeed().x;
+    speedZ[index] = wave.getWaveSpeed().z;
+    accelerationX[index] = wave.getWaveAcceleration().x;
+    accelerationZ[index] = wave.getWaveAcceleration().z;
+    height[index] = wave.getWaveHeight();
+    radius[index] = wave.getWaveRadius();
+}
+
+
+void ConicWaveColumns::move(int from, int to)
+{
+    originX[to] = originX[from];
+    originZ[to] = originZ[from];
+    speedX[to] = speedX[from];
+    speedZ[to] = speedZ[from];
+    accelerationX[to] = accelerationX[from];
+    accelerationZ[to] = accelerationZ[from];
+    height[to] = height[from];
+    radius[to] = radius[from];
+}
+
+
+void ConicWaveColumns::pop()
+{
+    originX.pop_back();
+    originZ.pop_back();
+    speedX.pop_back();
+    speedZ.pop_back();
+    accelerationX.pop_back();
+    accelerationZ.pop_back();
+    height.pop_back();
+    radius.pop_back();
+}
+
+
+void ConicWaveColumns::addToBatch(WaveBatch &batch) const
+{
+    for(int i = 0; i < size(); i++) {
+        // A flat cone does not deform anything
+        if(height[i] != 0) {
+            batch.conics.push_back(ConicKernelParams(originX[i], originZ[i], radius[i], height[i]));
+        }
+    }
+}
+
+
+void ConicWaveColumns::deformRows(const GridView &grid, int ligneDebut, int ligneFin) const
+{
+    ConicRowKernel kernel = getWaveKernels().conicRow;
+
+    for(int i = 0; i < size(); i++) {
+        if(height[i] == 0) {
+            continue;
+        }
+        ConicKernelParams params(originX[i], originZ[i], radius[i], height[i]);
+        GridRect rect = grid.discRect(originX[i], originZ[i], radius[i]);
+        if(rect.isEmpty()) {
+            continue;
+        }
+
+        int fin = std::min(ligneFin, rect.ligneFin);
+        for(int ligne = std::max(ligneDebut, rect.ligneDebut); ligne < fin; ligne++) {
+            int colonneDebut, colonneFin;
+            grid.discRowSpan(originX[i], originZ[i], radius[i], ligne, &colonneDebut, &colonneFin);
+            if(colonneDebut < colonneFin) {
+                kernel(grid.row(ligne), colonneDebut, colonneFin, grid.x(0), grid.step, grid.z(ligne), params);
+            }
+        }
+    }
+}
+
+
+void ConicWaveColumns::update(double delta_t, int nbPointsX, int nbPointsZ)
+{
+    for(int i = 0; i < size(); i++) {
+        ConicWave::moveOrigin(delta_t, nbPointsX, nbPointsZ, originX[i], originZ[i], speedX[i], speedZ[i], height[i]);
+    }
+}
+
+
+/***************************************************************************/
+/* CircularWave table                                                      */
+/***************************************************************************/
+void CircularWaveColumns::push(const CircularWave &wave)
+{
+    originX.push_back(wave.getWaveOrigin().x);
+    originZ.push_back(wave.getWaveOrigin().z);
+    height.push_back(wave.getWaveHeight());
+    width.push_back(wave.getWaveWidth());
+    radius.push_back(wave.getWaveRadius());
+    speed.push_back(wave.getWaveSpeed());
+    acceleration.push_back(wave.getWaveAcceleration());
+    epsilon.push_back(wave.getAmplitudeEpsilon());
+    inPhasorField.push_back(0);
+}
+
+
+CircularWave CircularWaveColumns::getAt(int index) const
+{
+    return CircularWave(Point(originX[index], 0, originZ[index]), height[index], width[index], radius[index],
+                        speed[index], acceleration[index], epsilon[index]);
+}
+
+
+void CircularWaveColumns::setAt(int index, const CircularWave &wave)
+{
+    originX[index] = wave.getWaveOrigin().x;
+    originZ[index] = wave.getWaveOrigin().z;
+    height[index] = wave.getWaveHeight();
+    width[index] = wave.getWaveWidth();
+    radius[index] = wave.getWaveRadius();
+    speed[index] = wave.getWaveSpeed();
+    acceleration[index] = wave.getWaveAcceleration();
+    epsilon[index] = wave.getAmplitudeEpsilon();
+}
+
+
+void CircularWaveColumns::move(int from, int to)
+{
+    originX[to] = originX[from];
+    originZ[to] = originZ[from];
+    height[to] = height[from];
+    width[to] = width[from];
+    radius[to] = radius[from];
+    speed[to] = speed[from];
+    acceleration[to] = acceleration[from];
+    epsilon[to] = epsilon[from];
+    inPhasorField[to] = inPhasorField[from];
+}
+
+
+void CircularWaveColumns::pop()
+{
+    originX.pop_back();
+    originZ.pop_back();
+    height.pop_back();
+    width.pop_back();
+    radius.pop_back();
+    speed.pop_back();
+    acceleration.pop_back();
+    epsilon.pop_back();
+    inPhasorField.pop_back();
+}
+
+
+void CircularWaveColumns::addToBatch(WaveBatch &batch) const
+{
+    for(int i = 0; i < size(); i++) {
+        if(height[i] != 0 && !inPhasorField[i]) {
+            batch.addCircular(CircularKernelParams(originX[i], originZ[i], radius[i], width[i], height[i], epsilon[i]));
+        }
+    }
+}
+
+
+void CircularWaveColumns::deformRows(const GridView &grid, int ligneDebut, int ligneFin) const
+{
+    CircularRowKernel kernel = getWaveKernels().circularRow;
+
+    for(int i = 0; i < size(); i++) {
+        if(height[i] == 0) {
+            continue;
+        }
+        CircularKernelParams params(originX[i], originZ[i], radius[i], width[i], height[i], epsilon[i]);
+        GridRect rect = grid.discRect(originX[i], originZ[i], params.reach);
+        if(rect.isEmpty()) {
+            continue;
+        }
+
+        int fin = std::min(ligneFin, rect.ligneFin);
+        for(int ligne = std::max(ligneDebut, rect.ligneDebut); ligne < fin; ligne++) {
+            int colonneDebut, colonneFin;
+            grid.discRowSpan(originX[i], originZ[i], params.reach, ligne, &colonneDebut, &colonneFin);
+            if(colonneDebut < colonneFin) {
+                kernel(grid.row(ligne), colonneDebut, colonneFin, grid.x(0), grid.step, grid.z(ligne), params);
+            }
+        }
+    }
+}
+
+
+void CircularWaveColumns::update(double delta_t, int, int)
+{
+    // Contiguous radius and speed arrays : vectorized by the compiler
+    for(int i = 0; i < size(); i++) {
+        radius[i] += speed[i]*delta_t;
+    }
+}
+
+
+void WaveRegistry::retireCirculars(const GridView &grid)
+{
+    // Backwards : the last wave, moved into the slot of a removed one, has already been checked
+    // A zero height parks a wave until it is given one (the demo keys) : it is kept
+    for(int i = circulars.size() - 1; i >= 0; i--) {
+        if(circulars.height[i] != 0 && circulars.getAt(i).isRetired(grid)) {
+            circulars.remove(circulars.handleAt(i));
+        }
+    }
+}
@@ -0,0 +1,347 @@
+#include <algorithm>
+#include <cmath>
+#include "waves.h"
+
+
+//Wave::Wave(Point waveOrigin) {
+//    this->waveOrigin = waveOrigin;
+//}
+
+GridRect Wave::getInfluenceRect(const GridView &grid)
+{
+    return GridRect(0, grid.nbPointsZ, 0, grid.nbPointsX);
+}
+
+void Wave::getRowSpan(const GridView &, const GridRect &rect, int, int *debut, int *fin)
+{
+    *debut = rect.colonneDebut;
+    *fin = rect.colonneFin;
+}
+
+void Wave::deformRows(const GridView &grid, int ligneDebut, int ligneFin)
+{
+    GridRect rect = getInfluenceRect(grid);
+    if(rect.isEmpty()) {
+        return;
+    }
+
+    ligneDebut = std::max(ligneDebut, rect.ligneDebut);
+    ligneFin = std::min(ligneFin, rect.ligneFin);
+    for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+        int debut, fin;
+        getRowSpan(grid, rect, ligne, &debut, &fin);
+        if(debut < fin) {
+            deformRow(grid, ligne, debut, fin);
+        }
+    }
+}
+
+ConicWave::ConicWave(Point waveOrigin, GLfloat waveHeight, GLfloat waveRadius, Vector waveSpeed, Vector waveAcceleration) {
+    this->waveOrigin = waveOrigin;
+    this->waveHeight = waveHeight;
+    this->waveRadius = waveRadius;
+    this->waveSpeed = waveSpeed;
+    this->waveAcceleration = waveAcceleration;
+    rebase();
+}
+
+void ConicWave::rebase() {
+    referenceTime = time;
+    referenceOrigin = waveOrigin;
+    referenceSpeed = waveSpeed;
+    referenceHeight = waveHeight;
+}
+
+void ConicWave::updateWave(double delta_t, int nbPointsX, int nbPointsZ) {
+    time += delta_t;
+    waveOrigin.y += delta_t * waveSpeed.y;
+    moveOrigin(delta_t, nbPointsX, nbPointsZ, waveOrigin.x, waveOrigin.z, waveSpeed.x, waveSpeed.z, waveHeight);
+}
+
+ConicWave ConicWave::evaluateAt(double t, int nbPointsX, int nbPointsZ) const {
+    ConicWave wave = *this;
+    wave.seek(t, nbPointsX, nbPointsZ);
+    return wave;
+}
+
+bool ConicWave::seek(double t, int nbPointsX, int nbPointsZ) {
+    // Moved from the reference state, not from the current one : the result does not depend on the steps taken
+    waveOrigin = referenceOrigin;
+    waveSpeed = referenceSpeed;
+    waveHeight = referenceHeight;
+    time = referenceTime;
+    updateWave(t - referenceTime, nbPointsX, nbPointsZ);
+    return true;
+}
+
+// Moves a coordinate between the borders -demiLargeur and demiLargeur, reflected on them
+// The path is unfolded on the line, then folded back in the band of width 2*demiLargeur it ends in
+// Returns the number of bounces, negative when going back in time
+static double reflect(double &x, double &speed, double delta_t, double demiLargeur) {
+    if(demiLargeur <= 0) {
+        x += delta_t * speed;
+        return 0;
+    }
+    double largeur = 2*demiLargeur;
+    double bandeDebut = floor((x + demiLargeur) / largeur);
+    double deplie = x + delta_t * speed;
+    double bande = floor((deplie + demiLargeur) / largeur);
+    // Odd bands are mirrored, and so is the speed
+    x = deplie - bande*largeur;
+    if(fmod(bande, 2) != 0) {
+        x = -x;
+        speed = -speed;
+    }
+    return delta_t >= 0 ? fabs(bande - bandeDebut) : -fabs(bande - bandeDebut);
+}
+
+void ConicWave::moveOrigin(double delta_t, int nbPointsX, int nbPointsZ,
+                           double &x, double &z, double &speedX, double &speedZ, GLfloat &height) {
+    double coeffAmortissement = 0.9;
+
+    double nbBounces = reflect(x, speedX, delta_t, 0.5*nbPointsX) + reflect(z, speedZ, delta_t, 0.5*nbPointsZ);
+    if(nbBounces != 0) {
+        height *= pow(coeffAmortissement, nbBounces);
+    }
+}
+
+GridRect ConicWave::getInfluenceRect(const GridView &grid) {
+    // A flat cone does not deform anything
+    if(getWaveHeight() == 0) {
+        return GridRect();
+    }
+    return grid.discRect(waveOrigin.x, waveOrigin.z, getWaveRadius());
+}
+
+void ConicWave::getRowSpan(const GridView &grid, const GridRect &, int ligne, int *debut, int *fin) {
+    grid.discRowSpan(waveOrigin.x, waveOrigin.z, getWaveRadius(), ligne, debut, fin);
+}
+
+bool ConicWave::addToBatch(WaveBatch &batch) {
+    // A flat cone does not deform anything
+    if(getWaveHeight() != 0) {
+        batch.conics.push_back(ConicKernelParams(waveOrigin.x, waveOrigin.z, getWaveRadius(), getWaveHeight()));
+    }
+    return true;
+}
+
+void ConicWave::deformRow(const GridView &grid, int ligne, int debut, int fin) {
+        // The row kernel is the best one for this CPU
+        ConicKernelParams params(waveOrigin.x, waveOrigin.z, getWaveRadius(), getWaveHeight());
+        getWaveKernels().conicRow(grid.row(ligne), debut, fin, grid.x(0), grid.step, grid.z(ligne), params);
+}
+
+CircularWave::CircularWave(Point waveOrigin, GLfloat waveHeight, GLfloat waveWidth, GLfloat waveRadius, GLfloat waveSpeed, GLfloat waveAcceleration,
+                           GLfloat amplitudeEpsilon) {
+    this->waveOrigin = waveOrigin;
+    this->waveWidth = waveWidth;
+    this->waveHeight = waveHeight;
+    this->waveRadius = waveRadius;
+    this->waveSpeed = waveSpeed;
+    this->waveAcceleration = waveAcceleration;
+    this->amplitudeEpsilon = amplitudeEpsilon;
+    rebase();
+}
+
+CircularKernelParams CircularWave::getParams() const {
+    return CircularKernelParams(waveOrigin.x, waveOrigin.z, getWaveRadius(), getWaveWidth(), getWaveHeight(), amplitudeEpsilon);
+}
+
+GLfloat CircularWave::getCutoffRadius() const {
+    // The reach of a ring large enough not to limit it
+    return CircularKernelParams(0, 0, 1e30f, 1, getWaveHeight(), amplitudeEpsilon).reach;
+}
+
+void CircularWave::updateWave(double delta_t, int, int) {
+        time += delta_t;
+        waveRadius += getWaveSpeed()*delta_t;
+}
+
+CircularWave CircularWave::evaluateAt(double t, int nbPointsX, int nbPointsZ) const {
+    CircularWave wave = *this;
+    wave.seek(t, nbPointsX, nbPointsZ);
+    return wave;
+}
+
+bool CircularWave::seek(double t, int, int) {
+    time = t;
+    waveRadius = referenceRadius + getWaveSpeed()*(t - referenceTime);
+    return true;
+}
+
+GridRect CircularWave::getInfluenceRect(const GridView &grid) {
+    // Every point within radius + width/2 is deformed, not only the ring around the radius
+    if(getWaveHeight() == 0) {
+        return GridRect();
+    }
+    return grid.discRect(waveOrigin.x, waveOrigin.z, getParams().reach);
+}
+
+void CircularWave::getRowSpan(const GridView &grid, const GridRect &, int ligne, int *debut, int *fin) {
+    grid.discRowSpan(waveOrigin.x, waveOrigin.z, getParams().reach, ligne, debut, fin);
+}
+
+bool CircularWave::addToBatch(WaveBatch &batch) {
+    if(getWaveHeight() != 0) {
+        batch.addCircular(getParams());
+    }
+    return true;
+}
+
+void CircularWave::deformRow(const GridView &grid, int ligne, int debut, int fin) {
+        // The row kernel is the best one for this CPU
+        getWaveKernels().circularRow(grid.row(ligne), debut, fin, grid.x(0), grid.step, grid.z(ligne), getParams());
+}
+
+bool CircularWave::isRetired(const GridView &grid) {
+    if(amplitudeEpsilon <= 0) {
+        return false;
+    }
+    double dx = std::max(0.0, std::max(grid.x(0) - waveOrigin.x, waveOrigin.x - grid.x(grid.nbPointsX - 1)));
+    double dz = std::max(0.0, std::max(grid.z(0) - waveOrigin.z, waveOrigin.z - grid.z(grid.nbPointsZ - 1)));
+    return fabs(getWaveHeight()) < amplitudeEpsilon || sqrt(dx*dx + dz*dz) > getCutoffRadius();
+}
+
+GerstnerComponent::GerstnerComponent(GLfloat amplitude, GLfloat wavelength, GLfloat direction, GLfloat steepness,
+                                     GLfloat phase) {
+    this->amplitude = amplitude;
+    this->wavelength = wavelength;
+    this->direction = direction;
+    this->steepness = steepness;
+    this->phase = phase;
+}
+
+GerstnerWave::GerstnerWave(Point waveOrigin, const std::vector<GerstnerComponent> &components) {
+    this->waveOrigin = waveOrigin;
+    this->components = components;
+    time = 0;
+    updateParams();
+}
+
+void GerstnerWave::addComponent(const GerstnerComponent &component) {
+    components.push_back(component);
+    updateParams();
+}
+
+void GerstnerWave::clearComponents() {
+    components.clear();
+    updateParams();
+}
+
+void GerstnerWave::updateParams() {
+    double pi = 3.14159265358979323846;
+    double g = 9.81;
+
+    WaveBatch merged;
+    for(int i = 0; i < int(components.size()); i++) {
+        const GerstnerComponent &component = components[i];
+        double k = 2*pi / component.wavelength;
+        double dirX = cos(component.direction), dirZ = sin(component.direction);
+        // Phase of the point at the origin, deep water dispersion omega = sqrt(g*k)
+        double angle = component.phase - sqrt(g*k)*time - k*(dirX*waveOrigin.x + dirZ*waveOrigin.z);
+        double c = cos(angle), s = sin(angle);
+        // The horizontal circle radius is steepness/k : a single component loops beyond steepness 1
+        double horizontal = component.steepness / k;
+
+        GerstnerKernelParams p;
+        p.kx = k*dirX;
+        p.kz = k*dirZ;
+        p.reVertical = component.amplitude*c;
+        p.imVertical = component.amplitude*s;
+        p.reHorizontalX = horizontal*dirX*c;
+        p.imHorizontalX = horizontal*dirX*s;
+        p.reHorizontalZ = horizontal*dirZ*c;
+        p.imHorizontalZ = horizontal*dirZ*s;
+        merged.addGerstner(p);
+    }
+    params.swap(merged.gerstners);
+}
+
+GridRect GerstnerWave::getInfluenceRect(const GridView &grid) {
+    // Without components the sea is flat, otherwise the waves cover the whole plane
+    if(params.empty()) {
+        return GridRect();
+    }
+    return Wave::getInfluenceRect(grid);
+}
+
+void GerstnerWave::deformRow(const GridView &grid, int ligne, int debut, int fin) {
+        getWaveKernels().gerstnerRow(grid.row(ligne), grid.rowX(ligne), grid.rowZ(ligne), debut, fin, grid.x(0), grid.step,
+                                     grid.z(ligne), params.data(), params.size());
+}
+
+bool GerstnerWave::addToBatch(WaveBatch &batch) {
+    for(int i = 0; i < int(params.size()); i++) {
+        batch.addGerstner(params[i]);
+    }
+    return true;
+}
+
+void GerstnerWave::updateWave(double delta_t, int, int) {
+    time += delta_t;
+    updateParams();
+}
+
+bool GerstnerWave::seek(double t, int, int) {
+    setTime(t);
+    return true;
+}
+
+
+PlaneWave::PlaneWave(Point waveOrigin, GLfloat amplitude, GLfloat wavelength, GLfloat direction, GLfloat phase) {
+    this->waveOrigin = waveOrigin;
+    this->amplitude = amplitude;
+    this->wavelength = wavelength;
+    this->direction = direction;
+    this->phase = phase;
+    time = 0;
+    updateParams();
+}
+
+void PlaneWave::updateParams() {
+    double pi = 3.14159265358979323846;
+    double g = 9.81;
+    double k = 2*pi / wavelength;
+    double dirX = cos(direction), dirZ = sin(direction);
+    double angle = phase - sqrt(g*k)*time - k*(dirX*waveOrigin.x + dirZ*waveOrigin.z);
+
+    params.kx = k*dirX;
+    params.kz = k*dirZ;
+    params.amplitude = amplitude;
+    // Kept small so that kz*z + phase stays accurate in single precision
+    params.phase = angle - 2*pi*floor(angle / (2*pi));
+}
+
+GridRect PlaneWave::getInfluenceRect(const GridView &grid) {
+    if(amplitude == 0) {
+        return GridRect();
+    }
+    return Wave::getInfluenceRect(grid);
+}
+
+void PlaneWave::deformRow(const GridView &grid, int ligne, int debut, int fin) {
+    // Alone, the wave is a Gerstner component without horizontal motion : cos(theta + phase) = Im(i e^(i phase) e^(i theta))
+    GerstnerKernelParams p = GerstnerKernelParams();
+    p.kx = params.kx;
+    p.kz = params.kz;
+    p.reVertical = -amplitude*sin(params.phase);
+    p.imVertical = amplitude*cos(params.phase);
+    getWaveKernels().gerstnerRow(grid.row(ligne), NULL, NULL, debut, fin, grid.x(0), grid.step, grid.z(ligne), &p, 1);
+}
+
+bool PlaneWave::addToBatch(WaveBatch &batch) {
+    if(amplitude != 0) {
+        batch.planes.push_back(params);
+    }
+    return true;
+}
+
+void PlaneWave::updateWave(double delta_t, int, int) {
+    time += delta_t;
+    updateParams();
+}
+
+bool PlaneWave::seek(double t, int, int) {
+    setTime(t);
+    return true;
+}
@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+#include "wavesolver.h"
+#include "wavekernels.h"
+
+// Lines per band : the three lines read by the stencil stay in the L1 cache from one line to the next
+const int STENCIL_BAND_SIZE = 32;
+// A very long frame is not fully simulated rather than spending more than this many sub-steps on it
+const int MAX_SUB_STEPS = 16;
+
+
+// Stencil on a band of lines, the heights being integrated one line behind
+// A line of the band can be moved as soon as the stencil of the next one is done, except the first
+// and last lines that the neighbour bands still read : they are moved by BorderIntegrationTask
+class StencilBandTask : public RowTask
+{
+public:
+    HeightField *field;
+    const HeightField *sources;
+    WaveEquationParams params;
+    void run(int ligneDebut, int ligneFin)
+    {
+        const WaveKernels &kernels = getWaveKernels();
+        int nbLignes = field->getNbPointsZ();
+        int nbPoints = field->getNbPointsX();
+
+        for(int ligne = ligneDebut; ligne < ligneFin; ligne++) {
+            int i = field->index(ligne, 0);
+            const GLfloat *dessus = field->heights() + field->index(std::max(ligne-1, 0), 0);
+            const GLfloat *dessous = field->heights() + field->index(std::min(ligne+1, nbLignes-1), 0);
+            kernels.waveEquationRow(field->speeds() + i, field->accelerations() + i, field->heights() + i,
+                                    dessus, dessous, sources != NULL ? sources->heights() + i : NULL,
+                                    nbPoints, params);
+
+            if(ligne - 1 > ligneDebut) {
+                int precedente = field->index(ligne-1, 0);
+                kernels.integrateRow(field->heights() + precedente, field->speeds() + precedente, nbPoints, params.dt);
+            }
+        }
+    }
+};
+
+
+// Moves the first and last lines of every band, once all the stencils are done
+class BorderIntegrationTask : public RowTask
+{
+public:
+    HeightField *field;
+    float dt;
+    void run(int ligneDebut, int ligneFin)
+    {
+        IntegrateRowKernel kernel = getWaveKernels().integrateRow;
+        int nbPoints = field->getNbPointsX();
+
+        int i = field->index(ligneDebut, 0);
+        kernel(field->heights() + i, field->speeds() + i, nbPoints, dt);
+        if(ligneFin - 1 > ligneDebut) {
+            i = field->index(ligneFin - 1, 0);
+            kernel(field->heights() + i, field->speeds() + i, nbPoints, dt);
+        }
+    }
+};
+
+
+WaveEquationSolver::WaveEquationSolver(double waveSpeed, double stiffness, double damping, double sourceGain)
+{
+    this->waveSpeed = waveSpeed;
+    this->stiffness = stiffness;
+    this->damping = damping;
+    this->sourceGain = sourceGain;
+    courant = 0.5;
+}
+
+
+double WaveEquationSolver::getMaxTimeStep(double step) const
+{
+    return courant * step / waveSpeed;
+}
+
+
+void WaveEquationSolver::advance(HeightField &field, const HeightField *sources, double delta_t, ThreadPool &pool)
+{
+    if(delta_t <= 0 || field.speeds() == NULL || field.accelerations() == NULL) {
+        return;
+    }
+
+    double dtMax = getMaxTimeStep(field.getStep());
+    int nbSubSteps = ceil(delta_t / dtMax);
+    double dt = delta_t / nbSubSteps;
+    if(nbSubSteps > MAX_SUB_STEPS) {
+        nbSubSteps = MAX_SUB_STEPS;
+        dt = dtMax;
+    }
+
+    StencilBandTask stencil;
+    stencil.field = &field;
+    stencil.sources = sources;
+    stencil.params = WaveEquationParams(waveSpeed, field.getStep(), stiffness, damping, sourceGain, dt);
+
+    BorderIntegrationTask borders;
+    borders.field = &field;
+    borders.dt = dt;
+
+    for(int i = 0; i < nbSubSteps; i++) {
+        pool.parallelRows(stencil, field.getNbPointsZ(), STENCIL_BAND_SIZE);
+        pool.parallelRows(borders, field.getNbPointsZ(), STENCIL_BAND_SIZE);
+    }
+}